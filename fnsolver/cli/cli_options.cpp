@@ -23,6 +23,7 @@
 #include <optional>
 #include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -47,6 +48,8 @@ const std::string precious_resources_opt_str = "precious-resources";
 const std::string production_minimum_opt_str = "min-mining";
 const std::string revenue_minimum_opt_str = "min-revenue";
 const std::string storage_minimum_opt_str = "min-storage";
+const std::string constraint_mode_opt_str = "constraint-mode";
+const std::string repair_offspring_opt_str = "repair-offspring";
 
 const std::string iterations_opt_str = "iterations";
 const std::string bonus_iterations_opt_str = "bonus-iterations";
@@ -55,6 +58,8 @@ const std::string num_offspring_opt_str = "offspring";
 const std::string mutation_rate_opt_str = "mutation-rate";
 const std::string max_age_opt_str = "max-age";
 const std::string num_threads_opt_str = "threads";
+const std::string rng_seed_opt_str = "rng-seed";
+const std::string share_best_opt_str = "share-best";
 
 const CLI::Range non_zero(1u, std::numeric_limits<uint32_t>::max(), "NONZERO");
 
@@ -108,7 +113,31 @@ std::vector<double> parse_score_function_args(
   return score_function_args;
 }
 
+ScoreFunction parse_score_function_expression(const std::vector<std::string> &score_function_strs) {
+  // "expr:<text>" or "expr <text>", where unquoted text may have been split into several arguments
+  const std::string &first_str = score_function_strs.at(0);
+  std::string expression_text = first_str.starts_with(ScoreFunction::expression_prefix)
+      ? first_str.substr(ScoreFunction::expression_prefix.size())
+      : "";
+  for (size_t i = 1; i < score_function_strs.size(); ++i) {
+    if (!expression_text.empty()) {
+      expression_text += " ";
+    }
+    expression_text += score_function_strs.at(i);
+  }
+
+  try {
+    return ScoreFunction::create_expression(expression_text);
+  } catch (const std::invalid_argument &e) {
+    throw CLI::ValidationError(std::format("--{}: {}", score_function_opt_str, e.what()));
+  }
+}
+
 ScoreFunction parse_score_function(const std::vector<std::string> &score_function_strs) {
+  if (score_function_strs.at(0).starts_with(ScoreFunction::expression_prefix)) {
+    return parse_score_function_expression(score_function_strs);
+  }
+
   const std::string &score_function_type = score_function_strs.at(0);
   if (!ScoreFunction::type_for_str.contains(score_function_type)) {
     throw CLI::ValidationError(std::format("--{}: Unknown score function name \"{}\"",
@@ -142,6 +171,8 @@ ScoreFunction parse_score_function(const std::vector<std::string> &score_functio
         score_function_args.at(0),
         score_function_args.at(1),
         score_function_args.at(2));
+  case ScoreFunction::Type::expression:
+    return parse_score_function_expression(score_function_strs);
   default:
     throw CLI::HorribleError(std::format("--{}: Unsupported score function name \"{}\"",
         score_function_opt_str,
@@ -151,7 +182,7 @@ ScoreFunction parse_score_function(const std::vector<std::string> &score_functio
 
 std::optional<ScoreFunction> parse_tiebreaker_function(
     const std::string &tiebreaker_function_str,
-    const std::string &score_function_str) {
+    const ScoreFunction &score_function) {
   if (tiebreaker_function_str.empty()) {
     return {};
   }
@@ -163,11 +194,11 @@ std::optional<ScoreFunction> parse_tiebreaker_function(
   }
 
   const ScoreFunction::Type tiebreaker_function_type = ScoreFunction::type_for_str.at(tiebreaker_function_str);
-  if (tiebreaker_function_type == ScoreFunction::type_for_str.at(score_function_str)) {
+  if (tiebreaker_function_type == ScoreFunction::type_for_str.at(score_function.get_name())) {
     throw CLI::ValidationError(std::format("--{}/--{}: Tiebreaker may not be the same as score function (\"{}\")",
         score_function_opt_str,
         tiebreaker_function_opt_str,
-        score_function_str));
+        score_function.get_name()));
   }
 
   switch (tiebreaker_function_type) {
@@ -599,6 +630,16 @@ std::array<uint32_t, precious_resource::count> parse_precious_resource_minimums(
   return precious_resource_minimums;
 }
 
+ScoreFunction::ConstraintMode parse_constraint_mode(const std::string &constraint_mode_str) {
+  if (!ScoreFunction::constraint_mode_for_str.contains(constraint_mode_str)) {
+    throw CLI::ValidationError(std::format("--{}: Unknown constraint mode \"{}\"",
+        constraint_mode_opt_str,
+        constraint_mode_str));
+  }
+
+  return ScoreFunction::constraint_mode_for_str.at(constraint_mode_str);
+}
+
 void check_locked_sites_and_seed_overlap(
     const std::vector<Placement> &locked_sites,
     const std::vector<Placement> &seed) {
@@ -677,6 +718,8 @@ Options cli_options::parse(int argc, char **argv) {
   uint32_t production_minimum = 0;
   uint32_t revenue_minimum = 0;
   uint32_t storage_minimum = 0;
+  std::string constraint_mode_str = "zero";
+  bool repair_offspring = false;
 
   uint32_t iterations = 1000;
   uint32_t bonus_iterations = 0;
@@ -685,6 +728,8 @@ Options cli_options::parse(int argc, char **argv) {
   double mutation_rate = 0.04;
   uint32_t max_age = 50;
   uint32_t num_threads = std::thread::hardware_concurrency();
+  uint64_t rng_seed = 0;
+  bool share_best = false;
 
   // OPTIONS group
   app.set_config("--" + config_file_opt_name, "",
@@ -712,7 +757,9 @@ Options cli_options::parse(int argc, char **argv) {
       "- \"max_storage\": maximize Storage\n"
       "- \"ratio <mining_factor> <revenue_factor> <storage_factor>\": maximize yields with the given ratios between "
       "them\n"
-      "- \"weights <mining_weight> <revenue_weight> <storage_weight>\": maximize yieids with the given weights")
+      "- \"weights <mining_weight> <revenue_weight> <storage_weight>\": maximize yieids with the given weights\n"
+      "- \"expr:<expression>\": maximize an expression such as \"min(mining * 1.2, storage) + 50 * bonjelium\" over "
+      "mining, revenue, storage, and precious resource names, with + - * /, parentheses, min(...), and max(...)")
       ->group(score_function_group_name)
       ->required()
       ->option_text("TEXT <FLOAT:NONNEGATIVE...> REQUIRED");
@@ -810,6 +857,20 @@ Options cli_options::parse(int argc, char **argv) {
       "Requires that a generated FrontierNav layout yield at least the specified Storage\n\n"
       "Use of this option is discouraged")
       ->group(constraints_group_name);
+  app.add_option("--" + constraint_mode_opt_str, constraint_mode_str,
+      "Sets how FrontierNav layouts that do not meet the constraints are scored while solving\n\n"
+      "Must be one of:\n"
+      "- \"zero\": score them 0\n"
+      "- \"penalty\": score them below 0, by how far they fall short of each constraint relative to it, so that the "
+      "solver can work its way towards layouts that meet hard-to-meet constraints\n\n"
+      "Either way, a layout that meets the constraints never scores worse than one that does not.")
+      ->group(constraints_group_name);
+  app.add_flag("--" + repair_offspring_opt_str, repair_offspring,
+      "Repairs FrontierNav layout offspring that do not meet the Precious Resource constraints before scoring them\n\n"
+      "Probes that collect Precious Resources (Basic and Mining probes) are swapped onto the sites yielding the missing "
+      "ones, cheapest first, so that fewer offspring are rejected. This costs time scoring offspring that would otherwise "
+      "be rejected, so it is only worth it when offspring rarely meet the Precious Resource constraints on their own.")
+      ->group(constraints_group_name);
 
   const std::string solver_controls_group_name = "SOLVER ALGORITHM PARAMETERS";
   app.add_option("-n,--" + iterations_opt_str, iterations,
@@ -844,6 +905,17 @@ Options cli_options::parse(int argc, char **argv) {
       "exactly the number of logical processors on your computer.")
       ->group(solver_controls_group_name)
       ->check(non_zero);
+  const CLI::Option *rng_seed_opt = app.add_option("--" + rng_seed_opt_str, rng_seed,
+      "Seeds FnSolver's random number generation\n\n"
+      "If this option is not explicitly passed, every run is seeded differently. Runs with the same seed and options "
+      "generate the same FrontierNav layouts, regardless of the number of threads.")
+      ->group(solver_controls_group_name)
+      ->default_str("random");
+  app.add_flag("--" + share_best_opt_str, share_best,
+      "Lets threads age FrontierNav layouts against improvements other threads found earlier in the same iteration\n\n"
+      "This may converge faster with many threads, but results then depend on thread timing, so runs are no longer "
+      "reproducible with --" + rng_seed_opt_str + ".")
+      ->group(solver_controls_group_name);
 
   std::optional<ScoreFunction> score_function; // not actually optional, just don't want to make a default constructor
   std::optional<ScoreFunction> maybe_tiebreaker_function;
@@ -855,12 +927,13 @@ Options cli_options::parse(int argc, char **argv) {
   std::vector<Placement> seed;
 
   std::array<uint32_t, precious_resource::count> precious_resource_minimums;
+  ScoreFunction::ConstraintMode constraint_mode = ScoreFunction::ConstraintMode::zero;
 
   try {
     app.parse(argc, argv);
 
     score_function = parse_score_function(score_function_strs);
-    maybe_tiebreaker_function = parse_tiebreaker_function(tiebreaker_function_str, score_function_strs.at(0));
+    maybe_tiebreaker_function = parse_tiebreaker_function(tiebreaker_function_str, *score_function);
 
     probe_quantities = parse_probe_quantities(probe_quantity_strs);
 
@@ -876,6 +949,7 @@ Options cli_options::parse(int argc, char **argv) {
     }
 
     precious_resource_minimums = parse_precious_resource_minimums(precious_resource_strs);
+    constraint_mode = parse_constraint_mode(constraint_mode_str);
 
     // only possible if std::thread::hardware_concurrency() == 0
     if (num_threads == 0) {
@@ -897,8 +971,12 @@ Options cli_options::parse(int argc, char **argv) {
     export_config_file << std::endl;
 
     export_config_file << "# " << score_function_group_name << std::endl;
-    // must be non-empty
-    export_config_file << score_function_opt_str << " = " << to_config_str(score_function_strs) << std::endl;
+    // must be non-empty, and holds an expression as a single string, however its text was split into arguments
+    export_config_file << score_function_opt_str << " = "
+        << to_config_str(score_function->get_expression_text().empty()
+            ? score_function_strs
+            : std::vector<std::string>{ScoreFunction::expression_prefix + score_function->get_expression_text()})
+        << std::endl;
     export_config_file << tiebreaker_function_opt_str << " = \"" << tiebreaker_function_str << "\"" << std::endl;
     export_config_file << std::endl;
 
@@ -923,6 +1001,8 @@ Options cli_options::parse(int argc, char **argv) {
     export_config_file << production_minimum_opt_str << " = " << production_minimum << std::endl;
     export_config_file << revenue_minimum_opt_str << " = " << revenue_minimum << std::endl;
     export_config_file << storage_minimum_opt_str << " = " << storage_minimum << std::endl;
+    export_config_file << constraint_mode_opt_str << " = \"" << constraint_mode_str << "\"" << std::endl;
+    export_config_file << repair_offspring_opt_str << " = " << (repair_offspring ? "true" : "false") << std::endl;
     export_config_file << std::endl;
 
     export_config_file << "# " << solver_controls_group_name << std::endl;
@@ -933,6 +1013,9 @@ Options cli_options::parse(int argc, char **argv) {
     export_config_file << mutation_rate_opt_str << " = " << mutation_rate << std::endl;
     export_config_file << max_age_opt_str << " = " << max_age << std::endl;
     export_config_file << num_threads_opt_str << " = " << num_threads << std::endl;
+    export_config_file << (rng_seed_opt->count() == 0 ? "# " : "")
+        << rng_seed_opt_str << " = " << rng_seed << std::endl;
+    export_config_file << share_best_opt_str << " = " << (share_best ? "true" : "false") << std::endl;
   }
 
   return Options(
@@ -948,13 +1031,17 @@ Options cli_options::parse(int argc, char **argv) {
       production_minimum,
       revenue_minimum,
       storage_minimum,
+      constraint_mode,
+      repair_offspring,
       iterations,
       bonus_iterations,
       population_size,
       num_offspring,
       mutation_rate,
       max_age,
-      num_threads);
+      num_threads,
+      rng_seed_opt->count() == 0 ? std::nullopt : std::optional<uint64_t>(rng_seed),
+      share_best);
 }
 
 cli_options::ParseExit::ParseExit(int return_code)
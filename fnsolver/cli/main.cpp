@@ -4,18 +4,23 @@
 #include <fnsolver/data/probe.h>
 #include <fnsolver/layout/placement.h>
 #include <fnsolver/solver/options.h>
+#include <fnsolver/solver/presolve.h>
+#include <fnsolver/solver/score_function.h>
 #include <fnsolver/solver/solution.h>
 #include <fnsolver/solver/solver.h>
 #include <fnsolver/util/output.hpp>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <csignal>
+#include <cstdint>
 #include <format>
 #include <iostream>
 #include <map>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace {
@@ -141,7 +146,13 @@ void output_constraints_str(const Options &options) {
   const uint32_t revenue = options.get_revenue_minimum();
   const uint32_t storage = options.get_storage_minimum();
 
-  std::cout << "  Constraints:";
+  const bool is_penalized = options.get_constraint_mode() == ScoreFunction::ConstraintMode::penalty;
+  const bool is_repairing = options.get_repair_offspring();
+  std::cout << std::format("  Constraints{}:",
+      is_penalized && is_repairing ? " (penalized, repairing offspring)"
+        : is_penalized ? " (penalized)"
+        : is_repairing ? " (repairing offspring)"
+        : "");
 
   const bool no_yield_constraints = production == 0 && revenue == 0 && storage == 0;
 
@@ -232,7 +243,66 @@ void output_constraints_str(const Options &options) {
       {4, 4});
 }
 
-void output_options_report(const Options &options) {
+std::string name_for_bound(const Presolve::Bound &bound) {
+  switch (bound.kind) {
+  case Presolve::Bound::Kind::precious_resource:
+    return precious_resource::name_for_type.at(bound.precious_resource_type);
+  case Presolve::Bound::Kind::production:
+    return "Mining";
+  case Presolve::Bound::Kind::revenue:
+    return "Revenue";
+  case Presolve::Bound::Kind::storage:
+    return "Storage";
+  }
+  return "";
+}
+
+std::string quantity_str(const Presolve::Bound &bound, uint64_t quantity) {
+  if (bound.kind == Presolve::Bound::Kind::precious_resource) {
+    return std::format("{:.2f}", static_cast<double>(quantity) / 100.0);
+  }
+  return std::to_string(quantity);
+}
+
+void output_presolve_str(const Presolve &presolve) {
+  std::cout << "  Presolve:";
+  if (presolve.get_bounds().empty()) {
+    std::cout << " no constraints to check" << std::endl;
+    return;
+  }
+  std::cout << std::endl;
+
+  std::vector<std::string> bound_names;
+  std::vector<std::string> maxima;
+  std::vector<std::string> minimums;
+  for (const Presolve::Bound &bound : presolve.get_bounds()) {
+    bound_names.emplace_back(name_for_bound(bound) + ":");
+    maxima.emplace_back(std::format("at most {}", quantity_str(bound, bound.max)));
+    minimums.emplace_back(std::format("({} {})",
+        bound.can_be_met() ? "minimum" : "can't meet",
+        quantity_str(bound, bound.minimum)));
+  }
+  util::output_columns(
+      std::cout,
+      std::array<std::vector<std::string>, 4>{
+        std::vector<std::string>{""},
+        std::move(bound_names),
+        std::move(maxima),
+        std::move(minimums)
+      },
+      {util::Alignment::left, util::Alignment::left, util::Alignment::right, util::Alignment::left},
+      {4, 1, 1});
+  if (presolve.get_num_required_collecting_sites() > presolve.get_num_collecting_probes()) {
+    std::cout << std::format("    Sites forced to collect: {} (can't meet, {} collecting probes)",
+        presolve.get_num_required_collecting_sites(),
+        presolve.get_num_collecting_probes()) << std::endl;
+  } else {
+    std::cout << std::format("    Sites forced to collect: {}", presolve.get_forced_collecting_site_idxs().size())
+        << std::endl;
+  }
+}
+
+void output_options_report(const Options &options, const Presolve &presolve) {
   std::cout << "FnSolver prepared with the following configuration:" << std::endl;
 
   std::cout << std::format("  Score Function:      {}", options.get_score_function().get_details_str()) << std::endl;
@@ -250,6 +320,9 @@ void output_options_report(const Options &options) {
   output_constraints_str(options);
   std::cout << std::endl;
 
+  output_presolve_str(presolve);
+  std::cout << std::endl;
+
   std::cout << "  Solver Parameters:" << std::endl;
   util::output_columns(
       std::cout,
@@ -262,11 +335,12 @@ void output_options_report(const Options &options) {
           std::to_string(options.get_population_size()),
           std::to_string(options.get_num_offspring())
         },
-        std::vector<std::string>{"Mutation Rate:", "Max Age:", "Threads:"},
+        std::vector<std::string>{"Mutation Rate:", "Max Age:", "Threads:", "RNG Seed:"},
         std::vector<std::string>{
           std::format("{:.4f}%", options.get_mutation_rate() * 100),
           std::to_string(options.get_max_age()),
-          std::to_string(options.get_num_threads())
+          std::format("{}{}", options.get_num_threads(), options.get_share_best() ? " (sharing best)" : ""),
+          options.get_maybe_rng_seed() ? std::to_string(*options.get_maybe_rng_seed()) : "random"
         }
       },
       {
@@ -291,8 +365,33 @@ int main(int argc, char **argv) {
   }
   Options options = std::move(*maybe_options);
 
-  output_options_report(options);
+  // before the report, so the presolve sees the territories the solver will
+  for (const auto &[site_id, territories] : options.get_territory_overrides()) {
+    FnSite::override_territories(site_id, territories);
+  }
+
+  const Presolve presolve(options);
+  output_options_report(options, presolve);
   std::cout << std::endl;
+
+  if (presolve.is_infeasible()) {
+    std::cerr << "No layout can meet the constraints:" << std::endl;
+    for (const Presolve::Bound &bound : presolve.get_bounds()) {
+      if (!bound.can_be_met()) {
+        std::cerr << std::format("  {} can reach at most {}, short of the minimum {}",
+            name_for_bound(bound),
+            quantity_str(bound, bound.max),
+            quantity_str(bound, bound.minimum)) << std::endl;
+      }
+    }
+    if (presolve.get_num_required_collecting_sites() > presolve.get_num_collecting_probes()) {
+      std::cerr << std::format("  The precious resource minimums together need collecting probes on {} sites, but "
+          "there are only {} collecting probes",
+          presolve.get_num_required_collecting_sites(),
+          presolve.get_num_collecting_probes()) << std::endl;
+    }
+    return 1;
+  }
   std::cout << "Once FnSolver starts, you may press Ctrl-C (or your shell's alternative SIGINT key combo)" << std::endl;
   std::cout << "  to stop after the current iteration." << std::endl;
   std::cout << std::endl;
@@ -318,10 +417,6 @@ int main(int argc, char **argv) {
     }
   }
 
-  for (const auto &[site_id, territories] : options.get_territory_overrides()) {
-    FnSite::override_territories(site_id, territories);
-  }
-
   const Solver solver(std::move(options));
 
   auto progress_callback = [&options](const Solver::IterationStatus &iteration_status) {
@@ -339,11 +434,57 @@ int main(int argc, char **argv) {
     }();
     std::cout << std::format("Finished iteration {}/{}:", iteration_status.iteration, options.get_iterations())
     << std::endl;
-    std::cout << std::format("  Overall best score: {}", iteration_status.best_score) << std::endl;
+    std::cout << std::format("  Overall best score: {}{}",
+        iteration_status.best_score,
+        iteration_status.best_snapshot->meets_constraints ? "" : " (misses constraints)") << std::endl;
     std::cout << std::format("  Solutions killed:   {}", iteration_status.num_killed) << std::endl;
+    std::cout << std::format("  Offspring rejected: {}", iteration_status.num_rejected) << std::endl;
+    if (options.get_repair_offspring()) {
+      std::cout << std::format(
+          "  Offspring repaired: {}/{} ({:.2f}%)",
+          iteration_status.num_repaired,
+          iteration_status.num_repair_attempts,
+          iteration_status.num_repair_attempts == 0
+            ? 0.0
+            : 100.0 * static_cast<double>(iteration_status.num_repaired)
+              / static_cast<double>(iteration_status.num_repair_attempts)) << std::endl;
+    }
+    std::cout << std::format("  Offspring pruned:   {}", iteration_status.num_pruned) << std::endl;
+    std::cout << std::format("  No-op offspring:    {}", iteration_status.num_unchanged) << std::endl;
+    std::cout << std::format(
+        "  Cache hits:         {}/{} ({:.2f}%)",
+        iteration_status.num_cache_hits,
+        iteration_status.num_cache_lookups,
+        iteration_status.num_cache_lookups == 0
+          ? 0.0
+          : 100.0 * static_cast<double>(iteration_status.num_cache_hits)
+              / static_cast<double>(iteration_status.num_cache_lookups)) << std::endl;
+    const auto [min_utilization, mean_utilization, num_steals, num_allocations] = [&]() {
+      double min_utilization = 1.0;
+      double total_utilization = 0.0;
+      size_t num_steals = 0;
+      size_t num_allocations = 0;
+      for (const Solver::WorkerStatus &worker_status : iteration_status.worker_statuses) {
+        min_utilization = std::min(min_utilization, worker_status.utilization);
+        total_utilization += worker_status.utilization;
+        num_steals += worker_status.num_steals;
+        num_allocations += worker_status.num_allocations;
+      }
+      return std::make_tuple(
+          min_utilization,
+          total_utilization / static_cast<double>(std::max<size_t>(iteration_status.worker_statuses.size(), 1)),
+          num_steals,
+          num_allocations);
+    }();
+    std::cout << std::format(
+        "  Worker utilization: {:.2f}% min, {:.2f}% mean",
+        100.0 * min_utilization,
+        100.0 * mean_utilization) << std::endl;
+    std::cout << std::format("  Chunks stolen:      {}", num_steals) << std::endl;
+    std::cout << std::format("  Arena allocations:  {}", num_allocations) << std::endl;
     std::cout << std::format("  Last improvement:   {}", last_improvement_str) << std::endl;
     std::cout << std::format("  Yield for best score:") << std::endl;
-    iteration_status.best_layout.output_report(std::cout, 4, false, true, false, false);
+    iteration_status.best_snapshot->layout.output_report(std::cout, 4, false, true, false, false);
   };
   auto stop_callback = []() { return should_stop.load(); };
 
@@ -356,8 +497,11 @@ int main(int argc, char **argv) {
   }
 
   std::cout << std::endl;
+  if (!solver.get_best_snapshot()->meets_constraints) {
+    std::cout << "No layout found meets the constraints, so the best layout misses them" << std::endl;
+  }
   std::cout << "Best Layout:" << std::endl;
-  solution.get_layout().output_report(std::cout, 2, true, true, true, true);
+  solution.create_layout().output_report(std::cout, 2, true, true, true, true);
 
   return 0;
 }
@@ -1,6 +1,8 @@
 #include <fnsolver/data/fnsite.h>
 
 #include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/site_topology.h>
+#include <fnsolver/data/yield_table.h>
 
 #include <array>
 #include <cstdint>
@@ -297,12 +299,16 @@ const std::array<FnSite, FnSite::num_sites> &FnSite::sites = sites_mutable;
 // static
 void FnSite::override_territories(id_t site_id, uint32_t territories) {
   sites_mutable[idx_for_id.at(site_id)].territories = territories;
+  SiteTopology::refresh_territories();
+  YieldTable::refresh_territories();
 }
 
 void FnSite::reset_territories() {
   for (auto& site : sites_mutable) {
     site.territories = site.max_territories;
   }
+  SiteTopology::refresh_territories();
+  YieldTable::refresh_territories();
 }
 
 FnSite::FnSite(
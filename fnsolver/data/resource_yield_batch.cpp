@@ -0,0 +1,80 @@
+#include <fnsolver/data/resource_yield_batch.h>
+
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <utility>
+#include <vector>
+
+ResourceYieldBatch::ResourceYieldBatch(std::pmr::memory_resource *memory_resource)
+    : productions(memory_resource),
+      revenues(memory_resource),
+      storages(memory_resource),
+      precious_resource_quantities(
+          // a pmr vector keeps the memory resource it's constructed with, even when assigned to
+          [&]<size_t... precious_resource_idxs>(std::index_sequence<precious_resource_idxs...>) {
+            return std::array<std::pmr::vector<uint32_t>, precious_resource::count>{
+              ((void) precious_resource_idxs, std::pmr::vector<uint32_t>(memory_resource))...
+            };
+          }(std::make_index_sequence<precious_resource::count>())) {}
+
+void ResourceYieldBatch::clear() {
+  productions.clear();
+  revenues.clear();
+  storages.clear();
+  for (std::pmr::vector<uint32_t> &quantities : precious_resource_quantities) {
+    quantities.clear();
+  }
+}
+
+void ResourceYieldBatch::reserve(size_t capacity) {
+  productions.reserve(capacity);
+  revenues.reserve(capacity);
+  storages.reserve(capacity);
+  for (std::pmr::vector<uint32_t> &quantities : precious_resource_quantities) {
+    quantities.reserve(capacity);
+  }
+}
+
+void ResourceYieldBatch::push_back(const ResourceYield &resource_yield) {
+  productions.push_back(resource_yield.get_production());
+  revenues.push_back(resource_yield.get_revenue());
+  storages.push_back(resource_yield.get_storage());
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    precious_resource_quantities[precious_resource_idx].push_back(
+        resource_yield.get_precious_resource_quantities()[precious_resource_idx]);
+  }
+}
+
+void ResourceYieldBatch::push_back(const ResourceYieldBatch &other, size_t lane) {
+  productions.push_back(other.productions[lane]);
+  revenues.push_back(other.revenues[lane]);
+  storages.push_back(other.storages[lane]);
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    precious_resource_quantities[precious_resource_idx].push_back(
+        other.precious_resource_quantities[precious_resource_idx][lane]);
+  }
+}
+
+size_t ResourceYieldBatch::size() const {
+  return productions.size();
+}
+
+std::span<const uint32_t> ResourceYieldBatch::get_productions() const {
+  return productions;
+}
+
+std::span<const uint32_t> ResourceYieldBatch::get_revenues() const {
+  return revenues;
+}
+
+std::span<const uint32_t> ResourceYieldBatch::get_storages() const {
+  return storages;
+}
+
+std::span<const uint32_t> ResourceYieldBatch::get_precious_resource_quantities(size_t precious_resource_idx) const {
+  return precious_resource_quantities[precious_resource_idx];
+}
@@ -0,0 +1,42 @@
+#ifndef FNSOLVER_DATA_RESOURCE_YIELD_BATCH_H
+#define FNSOLVER_DATA_RESOURCE_YIELD_BATCH_H
+
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/** Resource yields of many layouts as a structure of arrays, one lane per layout, so they can be scored together. */
+class ResourceYieldBatch {
+  public:
+    /** Lanes are allocated from memory_resource */
+    explicit ResourceYieldBatch(std::pmr::memory_resource *memory_resource = std::pmr::get_default_resource());
+
+    ResourceYieldBatch(const ResourceYieldBatch &other) = default;
+    ResourceYieldBatch(ResourceYieldBatch &&other) = default;
+    ResourceYieldBatch &operator=(const ResourceYieldBatch &other) = default;
+    ResourceYieldBatch &operator=(ResourceYieldBatch &&other) = default;
+
+    void clear();
+    void reserve(size_t capacity);
+    void push_back(const ResourceYield &resource_yield);
+    /** Copies lane of other */
+    void push_back(const ResourceYieldBatch &other, size_t lane);
+    size_t size() const;
+
+    std::span<const uint32_t> get_productions() const;
+    std::span<const uint32_t> get_revenues() const;
+    std::span<const uint32_t> get_storages() const;
+    std::span<const uint32_t> get_precious_resource_quantities(size_t precious_resource_idx) const;
+  private:
+    std::pmr::vector<uint32_t> productions;
+    std::pmr::vector<uint32_t> revenues;
+    std::pmr::vector<uint32_t> storages;
+    std::array<std::pmr::vector<uint32_t>, precious_resource::count> precious_resource_quantities;
+};
+
+#endif // FNSOLVER_DATA_RESOURCE_YIELD_BATCH_H
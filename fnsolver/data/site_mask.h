@@ -0,0 +1,61 @@
+#ifndef FNSOLVER_DATA_SITE_MASK_H
+#define FNSOLVER_DATA_SITE_MASK_H
+
+#include <fnsolver/data/fnsite.h>
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+/** Set of site idxs, one bit per site. */
+class SiteMask {
+  public:
+    static constexpr size_t num_bits = 128;
+    static_assert(FnSite::num_sites <= num_bits);
+
+    constexpr SiteMask() : words{0, 0} {}
+
+    static constexpr SiteMask single(size_t site_idx) {
+      SiteMask mask;
+      mask.set(site_idx);
+      return mask;
+    }
+
+    constexpr bool test(size_t site_idx) const { return (words[site_idx / 64] >> (site_idx % 64)) & 1; }
+    constexpr void set(size_t site_idx) { words[site_idx / 64] |= uint64_t(1) << (site_idx % 64); }
+    constexpr void reset(size_t site_idx) { words[site_idx / 64] &= ~(uint64_t(1) << (site_idx % 64)); }
+
+    constexpr bool none() const { return (words[0] | words[1]) == 0; }
+    constexpr size_t count() const { return std::popcount(words[0]) + std::popcount(words[1]); }
+    /** Undefined if none() */
+    constexpr size_t lowest() const {
+      return words[0] != 0 ? std::countr_zero(words[0]) : 64 + std::countr_zero(words[1]);
+    }
+
+    /** Calls func(site_idx) for each site in the mask, in ascending order. */
+    template <typename Func>
+    constexpr void for_each(Func func) const {
+      for (size_t word_idx = 0; word_idx < words.size(); ++word_idx) {
+        for (uint64_t word = words[word_idx]; word != 0; word &= word - 1) {
+          func(word_idx * 64 + std::countr_zero(word));
+        }
+      }
+    }
+
+    constexpr SiteMask operator~() const { return SiteMask(~words[0], ~words[1]); }
+    constexpr SiteMask operator&(const SiteMask &other) const {
+      return SiteMask(words[0] & other.words[0], words[1] & other.words[1]);
+    }
+    constexpr SiteMask operator|(const SiteMask &other) const {
+      return SiteMask(words[0] | other.words[0], words[1] | other.words[1]);
+    }
+    constexpr SiteMask &operator&=(const SiteMask &other) { return *this = *this & other; }
+    constexpr SiteMask &operator|=(const SiteMask &other) { return *this = *this | other; }
+    constexpr bool operator==(const SiteMask &other) const = default;
+  private:
+    constexpr SiteMask(uint64_t low, uint64_t high) : words{low, high} {}
+
+    std::array<uint64_t, 2> words;
+};
+
+#endif // FNSOLVER_DATA_SITE_MASK_H
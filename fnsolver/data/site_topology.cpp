@@ -0,0 +1,81 @@
+#include <fnsolver/data/site_topology.h>
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/site_mask.h>
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+// static
+const SiteTopology &SiteTopology::get() {
+  return get_mutable();
+}
+
+// static
+void SiteTopology::refresh_territories() {
+  SiteTopology &topology = get_mutable();
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    topology.territories[site_idx] = FnSite::sites[site_idx].territories;
+  }
+}
+
+// static
+SiteTopology &SiteTopology::get_mutable() {
+  // Init inside function to workaround static initialization order.
+  static SiteTopology topology;
+  return topology;
+}
+
+SiteTopology::SiteTopology() {
+  size_t num_neighbors = 0;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    const FnSite &site = FnSite::sites[site_idx];
+
+    neighbor_offsets[site_idx] = static_cast<uint16_t>(num_neighbors);
+    for (const size_t neighbor_idx : site.neighbor_idxs) {
+      neighbor_idxs.at(num_neighbors++) = static_cast<site_idx_t>(neighbor_idx);
+      neighbor_masks[site_idx].set(neighbor_idx);
+    }
+
+    productions[site_idx] = site.production;
+    revenues[site_idx] = site.revenue;
+    territories[site_idx] = site.territories;
+    precious_resource_quantities[site_idx] = site.precious_resource_quantities;
+  }
+  neighbor_offsets[FnSite::num_sites] = static_cast<uint16_t>(num_neighbors);
+
+  if (num_neighbors != neighbor_idxs.size()) {
+    throw std::logic_error("FrontierNav site graph is not a tree");
+  }
+
+  // most central node, probably doesn't matter though
+  const site_idx_t root_idx = static_cast<site_idx_t>(FnSite::idx_for_id.at(111));
+
+  std::array<bool, FnSite::num_sites> visited;
+  visited.fill(false);
+  std::array<site_idx_t, FnSite::num_sites> stack;
+  size_t stack_size = 0;
+  size_t traversal_size = 0;
+
+  stack[stack_size++] = root_idx;
+  parent_idxs[root_idx] = none_idx;
+  visited[root_idx] = true;
+  while (stack_size != 0) {
+    const site_idx_t site_idx = stack[--stack_size];
+    traversal_order[traversal_size++] = site_idx;
+
+    for (const site_idx_t neighbor_idx : neighbors(site_idx)) {
+      if (!visited[neighbor_idx]) {
+        visited[neighbor_idx] = true;
+        parent_idxs[neighbor_idx] = site_idx;
+        stack[stack_size++] = neighbor_idx;
+      }
+    }
+  }
+
+  if (traversal_size != FnSite::num_sites) {
+    throw std::logic_error("FrontierNav site graph is not connected");
+  }
+}
@@ -0,0 +1,76 @@
+#ifndef FNSOLVER_DATA_SITE_TOPOLOGY_H
+#define FNSOLVER_DATA_SITE_TOPOLOGY_H
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/site_mask.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+/**
+ * Static site graph and the per-site fields read while evaluating layouts, precompiled once into flat arrays indexed by
+ * site idx. Everything else about a site (combat grade, display grades, etc.) stays in FnSite.
+ */
+class SiteTopology {
+  public:
+    using site_idx_t = uint8_t;
+
+    /** The site graph is a tree. */
+    static constexpr size_t num_links = FnSite::num_sites - 1;
+    /** Parent of the root site. */
+    static constexpr site_idx_t none_idx = FnSite::num_sites;
+
+    static const SiteTopology &get();
+
+    /** Re-reads territories from FnSite::sites after they have been overridden. */
+    static void refresh_territories();
+
+    SiteTopology(const SiteTopology &other) = delete;
+    SiteTopology(SiteTopology &&other) = delete;
+    SiteTopology &operator=(const SiteTopology &other) = delete;
+    SiteTopology &operator=(SiteTopology &&other) = delete;
+
+    /** Same order as FnSite::neighbor_idxs. */
+    std::span<const site_idx_t> neighbors(size_t site_idx) const {
+      return std::span<const site_idx_t>(
+          neighbor_idxs.data() + neighbor_offsets[site_idx],
+          neighbor_offsets[site_idx + 1] - neighbor_offsets[site_idx]);
+    }
+
+    const SiteMask &get_neighbor_mask(size_t site_idx) const { return neighbor_masks[site_idx]; }
+
+    size_t get_root_idx() const { return traversal_order[0]; }
+    /** Preorder DFS of the tree from the root, so every site comes after its parent. */
+    const std::array<site_idx_t, FnSite::num_sites> &get_traversal_order() const { return traversal_order; }
+    /** none_idx for the root. */
+    const std::array<site_idx_t, FnSite::num_sites> &get_parent_idxs() const { return parent_idxs; }
+
+    const std::array<uint32_t, FnSite::num_sites> &get_productions() const { return productions; }
+    const std::array<uint32_t, FnSite::num_sites> &get_revenues() const { return revenues; }
+    const std::array<uint32_t, FnSite::num_sites> &get_territories() const { return territories; }
+    const std::array<std::array<uint32_t, precious_resource::count>, FnSite::num_sites> &
+    get_precious_resource_quantities() const {
+      return precious_resource_quantities;
+    }
+  private:
+    SiteTopology();
+
+    // CSR adjacency, see neighbors()
+    std::array<uint16_t, FnSite::num_sites + 1> neighbor_offsets;
+    std::array<site_idx_t, 2 * num_links> neighbor_idxs;
+    std::array<SiteMask, FnSite::num_sites> neighbor_masks;
+
+    std::array<site_idx_t, FnSite::num_sites> traversal_order;
+    std::array<site_idx_t, FnSite::num_sites> parent_idxs;
+
+    std::array<uint32_t, FnSite::num_sites> productions;
+    std::array<uint32_t, FnSite::num_sites> revenues;
+    std::array<uint32_t, FnSite::num_sites> territories;
+    std::array<std::array<uint32_t, precious_resource::count>, FnSite::num_sites> precious_resource_quantities;
+
+    static SiteTopology &get_mutable();
+};
+
+#endif // FNSOLVER_DATA_SITE_TOPOLOGY_H
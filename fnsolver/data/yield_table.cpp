@@ -0,0 +1,72 @@
+#include <fnsolver/data/yield_table.h>
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/data/site_topology.h>
+
+#include <array>
+#include <cstdint>
+
+// static
+const YieldTable &YieldTable::get() {
+  return get_mutable();
+}
+
+// static
+void YieldTable::refresh_territories() {
+  get_mutable().resolve_entries();
+}
+
+// static
+YieldTable &YieldTable::get_mutable() {
+  // Init inside function to workaround static initialization order.
+  static YieldTable yield_table;
+  return yield_table;
+}
+
+YieldTable::YieldTable() {
+  resolve_entries();
+}
+
+void YieldTable::resolve_entries() {
+  const SiteTopology &topology = SiteTopology::get();
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    const uint32_t site_production = topology.get_productions()[site_idx];
+    const uint32_t site_revenue = topology.get_revenues()[site_idx];
+    const uint32_t site_territories = topology.get_territories()[site_idx];
+
+    for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+      const Probe &probe = Probe::probes[probe_idx];
+      const uint32_t probe_production = site_production * probe.production_factor / 100;
+      const uint32_t probe_revenue = site_revenue * probe.revenue_factor / 100;
+
+      Entry &entry = entries[site_idx][probe_idx];
+      switch (probe.probe_type) {
+      case Probe::Type::duplicator:
+        // yields the probes it copies instead
+        entry = Entry{{0, 0, 0}, 0, production};
+        break;
+      case Probe::Type::none: // fall-through
+      case Probe::Type::basic: // fall-through
+      case Probe::Type::booster: // fall-through
+      case Probe::Type::battle:
+        // chain/boost not relevant
+        entry = Entry{{probe_production, probe_revenue, 0}, 0, production};
+        break;
+      case Probe::Type::mining:
+        entry = Entry{{0, probe_revenue, 0}, probe_production, production};
+        break;
+      case Probe::Type::research:
+        entry = Entry{
+          {probe_production, 0, 0},
+          (site_revenue + 2000 * site_territories) * probe.revenue_factor / 100,
+          revenue
+        };
+        break;
+      case Probe::Type::storage:
+        entry = Entry{{probe_production, probe_revenue, 0}, probe.storage, storage};
+        break;
+      }
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef FNSOLVER_DATA_YIELD_TABLE_H
+#define FNSOLVER_DATA_YIELD_TABLE_H
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/probe.h>
+
+#include <array>
+#include <cstdint>
+
+/**
+ * Base yield of every probe on every site, before chain bonuses and incoming boosts, precomputed once per territory
+ * configuration. The remaining chain and boost multipliers are applied by the caller, in the same order and with the
+ * same integer truncation as ResolvedPlacement.
+ */
+class YieldTable {
+  public:
+    /** Which resource a probe's boostable value contributes to, indexes Entry::unboosted. */
+    enum BoostedYield : uint8_t {
+      production,
+      revenue,
+      storage,
+    };
+
+    struct Entry {
+      /** Production, revenue, and storage that no chain bonus or boost applies to. */
+      std::array<uint32_t, 3> unboosted;
+      /** Value the chain bonus and then any incoming boosts are applied to, 0 if the probe is not affected by either. */
+      uint32_t boostable;
+      BoostedYield boosted_yield;
+    };
+
+    static const YieldTable &get();
+
+    /** Rebuilds the table after territories have been overridden. Must come after SiteTopology::refresh_territories. */
+    static void refresh_territories();
+
+    YieldTable(const YieldTable &other) = delete;
+    YieldTable(YieldTable &&other) = delete;
+    YieldTable &operator=(const YieldTable &other) = delete;
+    YieldTable &operator=(YieldTable &&other) = delete;
+
+    const Entry &entry(size_t site_idx, size_t probe_idx) const { return entries[site_idx][probe_idx]; }
+  private:
+    YieldTable();
+
+    void resolve_entries();
+
+    std::array<std::array<Entry, Probe::num_probes>, FnSite::num_sites> entries;
+
+    static YieldTable &get_mutable();
+};
+
+#endif // FNSOLVER_DATA_YIELD_TABLE_H
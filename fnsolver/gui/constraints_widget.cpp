@@ -187,6 +187,35 @@ constrain by "number of sites that are yielding Precious Resources". As such, th
   init_min_yield_widget(&widgets_.min_storage_, &widgets_.min_storage_val_, tr("Min. Storage"),
                         solver_options->get_storage_minimum());
   yields_layout->addRow(widgets_.min_storage_, widgets_.min_storage_val_);
+
+  // Mode.
+  auto* mode = new QGroupBox(tr("Constraint Mode"));
+  layout->addWidget(mode);
+  auto* mode_layout = new QFormLayout();
+  mode->setLayout(mode_layout);
+  auto* mode_desc = new DescriptionWidget(tr(R"(
+Sets how FrontierNav layouts that do not meet the constraints are scored while solving.
+
+- **Zero**: score them 0.
+- **Penalty**: score them below 0, by how far they fall short of each constraint relative to it, so that the FnSolver
+  algorithm can work its way towards layouts that meet hard-to-meet constraints.
+
+Either way, a layout that meets the constraints never scores worse than one that does not.
+
+**Repair offspring** swaps Basic and Mining probes onto the sites yielding the Precious Resources that offspring miss,
+before scoring them. This costs time scoring offspring that would otherwise be rejected, so it is only worth it when
+offspring rarely meet the Precious Resource constraints on their own.
+)"), this);
+  mode_layout->addRow(mode_desc);
+  widgets_.mode_ = new QComboBox(this);
+  widgets_.mode_->addItem(tr("Zero"), static_cast<int>(ScoreFunction::ConstraintMode::zero));
+  widgets_.mode_->addItem(tr("Penalty"), static_cast<int>(ScoreFunction::ConstraintMode::penalty));
+  widgets_.mode_->setCurrentIndex(
+    widgets_.mode_->findData(static_cast<int>(solver_options->get_constraint_mode())));
+  mode_layout->addRow(tr("Mode"), widgets_.mode_);
+  widgets_.repair_offspring_ = new QCheckBox(tr("Repair offspring"), this);
+  widgets_.repair_offspring_->setChecked(solver_options->get_repair_offspring());
+  mode_layout->addRow(widgets_.repair_offspring_);
 }
 
 uint32_t resolve_yield(const QCheckBox* checkbox, const QSpinBox* spinbox) {
@@ -215,6 +244,10 @@ void ConstraintsWidget::apply_to_options(Options* options) const {
   options->set_production_minimum(resolve_yield(widgets_.min_mining_, widgets_.min_mining_val_));
   options->set_revenue_minimum(resolve_yield(widgets_.min_revenue_, widgets_.min_revenue_val_));
   options->set_storage_minimum(resolve_yield(widgets_.min_storage_, widgets_.min_storage_val_));
+
+  // Mode.
+  options->set_constraint_mode(static_cast<ScoreFunction::ConstraintMode>(widgets_.mode_->currentData().toInt()));
+  options->set_repair_offspring(widgets_.repair_offspring_->isChecked());
 }
 
 void ConstraintsWidget::
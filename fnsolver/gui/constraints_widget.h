@@ -71,6 +71,8 @@ class ConstraintsWidget : public AbstractSolverOptionsWidget {
     QSpinBox* min_revenue_val_;
     QCheckBox* min_storage_;
     QSpinBox* min_storage_val_;
+    QComboBox* mode_;
+    QCheckBox* repair_offspring_;
   };
 
   Widgets widgets_;
@@ -1,13 +1,11 @@
 #include "mira_map.h"
-#include <set>
-#include <unordered_set>
 #include <QApplication>
 #include <QWheelEvent>
 #include <QMenu>
 #include <QGraphicsProxyWidget>
-#include <QHash>
 #include <ranges>
 #include "fnsite_ui.h"
+#include "fnsolver/data/site_topology.h"
 #include "fn_site_widget.h"
 
 MiraMap::MiraMap(Layout* layout, const ImageProvider& image_provider, QWidget* parent) : QGraphicsView(parent),
@@ -145,12 +143,6 @@ void MiraMap::calculate_site_widgets() {
   calculate_links();
 }
 
-struct SiteIdSetHash {
-  std::size_t operator()(const std::set<FnSite::id_t>& ids) const noexcept {
-    return qHashRangeCommutative(ids.cbegin(), ids.cend());
-  }
-};
-
 static const auto no_combo_link_color = QColorConstants::Svg::cyan;
 static const auto with_combo_link_color = QColorConstants::Svg::deeppink;
 static const auto combo_circle_color = QColorConstants::Svg::red;
@@ -160,48 +152,35 @@ void MiraMap::calculate_links() {
   pen.setWidth(4);
   link_graphics_.clear();
   combo_graphics_.clear();
-  // Need to track which lines have already been drawn as both sides of the link
-  // are stored.
-  std::unordered_set<std::set<FnSite::id_t>, SiteIdSetHash> drawn_links;
-  auto placement = layout_->get_placements().cbegin();
-  auto resolved_placement = layout_->get_resolved_placements().cbegin();
-  for (; placement != layout_->get_placements().cend() && resolved_placement != layout_->get_resolved_placements().
-         cend();
-         ++placement, ++resolved_placement) {
-    const auto& site = placement->get_site();
-    const auto& site_probe = placement->get_probe();
-
-    const auto combo_bonus = resolved_placement->get_chain_bonus();
-    for (const auto neighbor_idx : site.neighbor_idxs) {
-      const auto& neighbor = FnSite::sites.at(neighbor_idx);
-      // Don't draw combo lines more than once.
-      const std::set link_pair{site.site_id, neighbor.site_id};
-      if (drawn_links.contains(link_pair)) {
-        // Already drawn line.
-        continue;
-      }
+  // The site graph is a tree, so drawing each site's link to its parent draws every link exactly once.
+  const auto& topology = SiteTopology::get();
+  const auto& placements = layout_->get_placements();
+  const auto& resolved_placements = layout_->get_resolved_placements();
+  for (size_t site_idx = 0; site_idx < placements.size() && site_idx < resolved_placements.size(); ++site_idx) {
+    const auto& site = placements[site_idx].get_site();
+    const auto& site_probe = placements[site_idx].get_probe();
+
+    const auto combo_bonus = resolved_placements[site_idx].get_chain_bonus();
+    const auto parent_idx = topology.get_parent_idxs()[site_idx];
+    if (parent_idx != SiteTopology::none_idx) {
+      const auto& parent = FnSite::sites.at(parent_idx);
 
       // Do not draw links between sites not visited.
-      const auto& neighbor_placement = layout_->get_placements().at(neighbor_idx);
-      const auto& neighbor_probe = neighbor_placement.get_probe();
-      if (site_probe.probe_type == Probe::Type::none || neighbor_probe.probe_type == Probe::Type::none) {
-        // Already visited.
-        continue;
+      const auto& parent_probe = placements.at(parent_idx).get_probe();
+      if (site_probe.probe_type != Probe::Type::none && parent_probe.probe_type != Probe::Type::none) {
+        if (combo_bonus > 1 && site_probe.probe_id == parent_probe.probe_id) {
+          pen.setColor(with_combo_link_color);
+        }
+        else {
+          pen.setColor(no_combo_link_color);
+        }
+
+        const auto [x1, y1] = site_positions.at(site.site_id);
+        const auto [x2, y2] = site_positions.at(parent.site_id);
+        auto& linkItem = link_graphics_.emplace_back(
+          map_scene_.addLine(QLine(x1, y1, x2, y2), pen));
+        linkItem->setZValue(z_links);
       }
-
-      if (combo_bonus > 1 && site_probe.probe_id == neighbor_probe.probe_id) {
-        pen.setColor(with_combo_link_color);
-      }
-      else {
-        pen.setColor(no_combo_link_color);
-      }
-
-      const auto [x1, y1] = site_positions.at(site.site_id);
-      const auto [x2, y2] = site_positions.at(neighbor.site_id);
-      auto& linkItem = link_graphics_.emplace_back(
-        map_scene_.addLine(QLine(x1, y1, x2, y2), pen));
-      linkItem->setZValue(z_links);
-      drawn_links.insert(link_pair);
     }
 
     // Draw circles on sites that are part of a combo.
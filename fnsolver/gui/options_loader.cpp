@@ -28,13 +28,17 @@ Options options_loader::default_options() {
     0,
     0,
     0,
+    ScoreFunction::ConstraintMode::zero,
+    false,
     1000,
     0,
     100,
     200,
     0.04,
     50,
-    static_cast<uint32_t>(QThread::idealThreadCount())
+    static_cast<uint32_t>(QThread::idealThreadCount()),
+    {},
+    false
   };
 }
 
@@ -95,6 +99,8 @@ const std::string precious_resources_opt_str = "precious-resources";
 const std::string production_minimum_opt_str = "min-mining";
 const std::string revenue_minimum_opt_str = "min-revenue";
 const std::string storage_minimum_opt_str = "min-storage";
+const std::string constraint_mode_opt_str = "constraint-mode";
+const std::string repair_offspring_opt_str = "repair-offspring";
 
 const std::string iterations_opt_str = "iterations";
 const std::string bonus_iterations_opt_str = "bonus-iterations";
@@ -103,6 +109,8 @@ const std::string num_offspring_opt_str = "offspring";
 const std::string mutation_rate_opt_str = "mutation-rate";
 const std::string max_age_opt_str = "max-age";
 const std::string num_threads_opt_str = "threads";
+const std::string rng_seed_opt_str = "rng-seed";
+const std::string share_best_opt_str = "share-best";
 
 /**
  * Helper to retrieve values of type @p T from a toml table.
@@ -387,6 +395,18 @@ Options options_loader::load_from_file(const std::string& filename) {
     options.set_storage_minimum(coerce_toml_node<uint32_t>(tbl.at(storage_minimum_opt_str)));
   }
 
+  // Constraint mode
+  if (tbl.contains(constraint_mode_opt_str)) {
+    const auto constraint_mode = coerce_toml_node<std::string>(tbl.at(constraint_mode_opt_str));
+    if (!ScoreFunction::constraint_mode_for_str.contains(constraint_mode)) {
+      throw std::runtime_error("Invalid constraint mode");
+    }
+    options.set_constraint_mode(ScoreFunction::constraint_mode_for_str.at(constraint_mode));
+  }
+  if (tbl.contains(repair_offspring_opt_str)) {
+    options.set_repair_offspring(coerce_toml_node<bool>(tbl.at(repair_offspring_opt_str)));
+  }
+
   // Solver params
   if (tbl.contains(iterations_opt_str)) {
     options.set_iterations(coerce_toml_node<uint32_t>(tbl.at(iterations_opt_str)));
@@ -409,11 +429,23 @@ Options options_loader::load_from_file(const std::string& filename) {
   if (tbl.contains(num_threads_opt_str)) {
     options.set_num_threads(coerce_toml_node<uint32_t>(tbl.at(num_threads_opt_str)));
   }
+  if (tbl.contains(rng_seed_opt_str)) {
+    options.set_maybe_rng_seed(coerce_toml_node<uint64_t>(tbl.at(rng_seed_opt_str)));
+  }
+  if (tbl.contains(share_best_opt_str)) {
+    options.set_share_best(coerce_toml_node<bool>(tbl.at(share_best_opt_str)));
+  }
 
   return options;
 }
 
 void save_score_function(toml::table& tbl, const Options& options) {
+  if (!options.get_score_function().get_expression_text().empty()) {
+    tbl.emplace(score_function_opt_str,
+                toml::array{ScoreFunction::expression_prefix + options.get_score_function().get_expression_text()});
+    return;
+  }
+
   toml::array score_function{options.get_score_function().get_name()};
   for (const auto& arg : options.get_score_function().get_args()) {
     score_function.emplace_back(arg.second);
@@ -538,6 +570,10 @@ void options_loader::save_to_file(const std::string& filename, const Options& op
   tbl.emplace(revenue_minimum_opt_str, options.get_revenue_minimum());
   tbl.emplace(storage_minimum_opt_str, options.get_storage_minimum());
 
+  // Constraint mode
+  tbl.emplace(constraint_mode_opt_str, ScoreFunction::str_for_constraint_mode.at(options.get_constraint_mode()));
+  tbl.emplace(repair_offspring_opt_str, options.get_repair_offspring());
+
   // Solver params
   tbl.emplace(iterations_opt_str, options.get_iterations());
   tbl.emplace(bonus_iterations_opt_str, options.get_bonus_iterations());
@@ -546,6 +582,11 @@ void options_loader::save_to_file(const std::string& filename, const Options& op
   tbl.emplace(mutation_rate_opt_str, options.get_mutation_rate());
   tbl.emplace(max_age_opt_str, options.get_max_age());
   tbl.emplace(num_threads_opt_str, options.get_num_threads());
+  if (options.get_maybe_rng_seed()) {
+    // TOML integers are signed, the bits round-trip through coerce_toml_node<uint64_t>
+    tbl.emplace(rng_seed_opt_str, static_cast<int64_t>(*options.get_maybe_rng_seed()));
+  }
+  tbl.emplace(share_best_opt_str, options.get_share_best());
 
   // Write output.
   std::ofstream out(filename);
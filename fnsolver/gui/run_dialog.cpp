@@ -6,11 +6,14 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QGroupBox>
+#include <QMessageBox>
 #include <QPushButton>
 #include <QScrollArea>
 #include <qstyle.h>
 
+#include "fnsolver/solver/presolve.h"
 #include "options_loader.h"
+#include "precious_resource_ui.h"
 #include "run_progress_dialog.h"
 
 RunDialog::RunDialog(Options* solver_options, QWidget* parent): QDialog(parent), solver_options_(solver_options) {
@@ -53,6 +56,7 @@ different layouts and determine which one is "better".
     ScoreFunction::Type::max_storage,
     ScoreFunction::Type::ratio,
     ScoreFunction::Type::weights,
+    ScoreFunction::Type::expression,
   });
   widgets_.scorefunction->set_selection(solver_options_->get_score_function());
   connect(widgets_.scorefunction, &ScoreFunctionWidget::selection_changed, this, &RunDialog::validate);
@@ -134,6 +138,49 @@ void RunDialog::solve() {
     Q_EMIT options_changed(solver_options);
   }
 
+  // Don't start solving if no layout can meet the constraints.
+  const Presolve presolve(solver_options);
+  if (presolve.is_infeasible()) {
+    QStringList unmet;
+    for (const Presolve::Bound& bound : presolve.get_bounds()) {
+      if (bound.can_be_met()) {
+        continue;
+      }
+      switch (bound.kind) {
+        case Presolve::Bound::Kind::precious_resource:
+          unmet.push_back(tr("%1 can reach at most %2, short of the minimum %3.")
+                            .arg(precious_resource_display_name(bound.precious_resource_type))
+                            .arg(QString::number(static_cast<double>(bound.max) / 100.0, 'f', 2))
+                            .arg(QString::number(static_cast<double>(bound.minimum) / 100.0, 'f', 2)));
+          break;
+        case Presolve::Bound::Kind::production:
+          unmet.push_back(tr("Mining can reach at most %1, short of the minimum %2.")
+                            .arg(bound.max)
+                            .arg(bound.minimum));
+          break;
+        case Presolve::Bound::Kind::revenue:
+          unmet.push_back(tr("Revenue can reach at most %1, short of the minimum %2.")
+                            .arg(bound.max)
+                            .arg(bound.minimum));
+          break;
+        case Presolve::Bound::Kind::storage:
+          unmet.push_back(tr("Storage can reach at most %1, short of the minimum %2.")
+                            .arg(bound.max)
+                            .arg(bound.minimum));
+          break;
+      }
+    }
+    if (presolve.get_num_required_collecting_sites() > presolve.get_num_collecting_probes()) {
+      unmet.push_back(tr("The precious resource minimums together need collecting probes on %1 sites, but there are "
+                         "only %2 collecting probes.")
+                        .arg(presolve.get_num_required_collecting_sites())
+                        .arg(presolve.get_num_collecting_probes()));
+    }
+    QMessageBox::warning(this, tr("Constraints can't be met"),
+                         tr("No layout can meet the constraints:\n%1").arg(unmet.join("\n")));
+    return;
+  }
+
   auto* run_progress = new RunProgressDialog(solver_options, this);
   connect(run_progress, &RunProgressDialog::solved, this, &RunDialog::solved);
   connect(run_progress, &RunProgressDialog::solved, this, &RunDialog::accept);
@@ -146,6 +193,12 @@ void RunDialog::validate() {
   }
 
   std::vector<std::function<void(QStringList& errors)>> validators{
+    [this](QStringList& errors) {
+      // Only an expression that does not parse leaves a required score function without a value.
+      if (!widgets_.scorefunction->get_score_function().has_value()) {
+        errors.push_back(tr("Score Function expression is invalid."));
+      }
+    },
     [this](QStringList& errors) {
       // Ensure the score function and tiebreaker are different.
       if (widgets_.scorefunction->get_score_function() == widgets_.tiebreaker->get_score_function()) {
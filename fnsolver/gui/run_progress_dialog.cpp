@@ -28,6 +28,24 @@ RunProgressDialog::RunProgressDialog(const Options& solver_options, QWidget* par
   layout->addRow(tr("Overall Best Score"), widgets_.best_score);
   widgets_.killed = new QLabel(this);
   layout->addRow(tr("Solutions Killed"), widgets_.killed);
+  widgets_.rejected = new QLabel(this);
+  layout->addRow(tr("Offspring Rejected"), widgets_.rejected);
+  if (solver_options_.get_repair_offspring()) {
+    widgets_.repaired = new QLabel(this);
+    layout->addRow(tr("Offspring Repaired"), widgets_.repaired);
+  }
+  widgets_.pruned = new QLabel(this);
+  layout->addRow(tr("Offspring Pruned"), widgets_.pruned);
+  widgets_.unchanged = new QLabel(this);
+  layout->addRow(tr("No-op Offspring"), widgets_.unchanged);
+  widgets_.cache_hits = new QLabel(this);
+  layout->addRow(tr("Cache Hits"), widgets_.cache_hits);
+  widgets_.worker_utilization = new QLabel(this);
+  layout->addRow(tr("Worker Utilization"), widgets_.worker_utilization);
+  widgets_.steals = new QLabel(this);
+  layout->addRow(tr("Chunks Stolen"), widgets_.steals);
+  widgets_.allocations = new QLabel(this);
+  layout->addRow(tr("Arena Allocations"), widgets_.allocations);
   widgets_.last_improvement = new QLabel(this);
   layout->addRow(tr("Last Improvement"), widgets_.last_improvement);
 
@@ -89,15 +107,53 @@ void RunProgressDialog::progress(const Solver::IterationStatus& iteration_status
   }
 
   // Status
-  widgets_.best_score->setText(locale.toString(iteration_status.best_score, 'f', 0));
+  if (iteration_status.best_snapshot->meets_constraints) {
+    widgets_.best_score->setText(locale.toString(iteration_status.best_score, 'f', 0));
+  }
+  else {
+    // Penalized scores are small fractions, which would round away.
+    widgets_.best_score->setText(
+      tr("%1 (misses constraints)").arg(locale.toString(iteration_status.best_score, 'f', 2)));
+  }
   widgets_.killed->setText(locale.toString(iteration_status.num_killed));
+  widgets_.rejected->setText(locale.toString(iteration_status.num_rejected));
+  if (widgets_.repaired != nullptr) {
+    widgets_.repaired->setText(tr("%1 of %2")
+                               .arg(locale.toString(iteration_status.num_repaired))
+                               .arg(locale.toString(iteration_status.num_repair_attempts))
+    );
+  }
+  widgets_.pruned->setText(locale.toString(iteration_status.num_pruned));
+  widgets_.unchanged->setText(locale.toString(iteration_status.num_unchanged));
+  widgets_.cache_hits->setText(tr("%1 of %2")
+                               .arg(locale.toString(iteration_status.num_cache_hits))
+                               .arg(locale.toString(iteration_status.num_cache_lookups))
+  );
+  double min_utilization = 1.0;
+  double total_utilization = 0.0;
+  std::size_t num_steals = 0;
+  std::size_t num_allocations = 0;
+  for (const auto& worker_status : iteration_status.worker_statuses) {
+    min_utilization = std::min(min_utilization, worker_status.utilization);
+    total_utilization += worker_status.utilization;
+    num_steals += worker_status.num_steals;
+    num_allocations += worker_status.num_allocations;
+  }
+  const double mean_utilization =
+    total_utilization / static_cast<double>(std::max<std::size_t>(iteration_status.worker_statuses.size(), 1));
+  widgets_.worker_utilization->setText(tr("%1% min, %2% mean")
+                                       .arg(locale.toString(100.0 * min_utilization, 'f', 1))
+                                       .arg(locale.toString(100.0 * mean_utilization, 'f', 1))
+  );
+  widgets_.steals->setText(locale.toString(num_steals));
+  widgets_.allocations->setText(locale.toString(num_allocations));
   const auto last_improvement_iteration = iteration_status.iteration - iteration_status.last_improvement;
   widgets_.last_improvement->setText(last_improvement_iteration == 0
                                        ? tr("This iteration")
                                        : tr("%n iteration(s) ago", "", last_improvement_iteration));
 
   // Yields
-  const auto resource_yield = iteration_status.best_layout.get_resource_yield();
+  const auto resource_yield = iteration_status.best_snapshot->layout.get_resource_yield();
   widgets_.mining->setText(locale.toString(resource_yield.get_production()));
   widgets_.revenue->setText(locale.toString(resource_yield.get_revenue()));
   widgets_.storage->setText(locale.toString(resource_yield.get_storage()));
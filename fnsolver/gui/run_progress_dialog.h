@@ -21,6 +21,15 @@ class RunProgressDialog : public QDialog {
     QLabel* time_remaining;
     QLabel* best_score;
     QLabel* killed;
+    QLabel* rejected;
+    // Only when repairing offspring.
+    QLabel* repaired = nullptr;
+    QLabel* pruned;
+    QLabel* unchanged;
+    QLabel* cache_hits;
+    QLabel* worker_utilization;
+    QLabel* steals;
+    QLabel* allocations;
     QLabel* last_improvement;
     QLabel* mining;
     QLabel* revenue;
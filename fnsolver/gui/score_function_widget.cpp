@@ -2,6 +2,7 @@
 #include <QButtonGroup>
 #include <QApplication>
 #include <qstyle.h>
+#include <stdexcept>
 
 namespace detail::score_function {
 ScoreFunctionSelectWidget::ScoreFunctionSelectWidget(ScoreFunctionWidget* parent): QWidget(parent),
@@ -193,6 +194,49 @@ void WeightsWidget::set_args(const ScoreFunction::args_map_t& args) {
 std::optional<ScoreFunction> WeightsWidget::get_score_function() const {
   return ScoreFunction::create_weights(mining_weight_->value(), revenue_weight_->value(), storage_weight_->value());
 }
+
+ExpressionWidget::ExpressionWidget(ScoreFunctionWidget* parent): ScoreFunctionSelectWidget(parent),
+  expression_(new QLineEdit(this)),
+  error_(new QLabel(this)) {
+  set_name(tr("Expression"));
+  set_description(tr(R"(
+- Takes one argument: an `Expression` such as `min(mining * 1.2, storage) + 0.1 * revenue + 50 * bonjelium`
+- Uses the value of the `Expression` as the score, or 0 if it is negative.
+- May use `mining`, `revenue`, `storage`, and precious resource names such as `arc_sand_ore`, numbers, `+`, `-`, `*`,
+  `/`, parentheses, and `min(...)` or `max(...)` of any number of arguments.
+- Dividing by 0 gives 0.
+)"));
+
+  form_->addRow(tr("Expression"), expression_);
+  form_->addRow(error_);
+  error_->setStyleSheet("color: #FF0000");
+  error_->setWordWrap(true);
+  error_->setVisible(false);
+  connect(expression_, &QLineEdit::textChanged, this, &ExpressionWidget::validate_expression);
+}
+
+void ExpressionWidget::set_expression_text(const std::string& expression_text) {
+  expression_->setText(QString::fromStdString(expression_text));
+}
+
+std::optional<ScoreFunction> ExpressionWidget::get_score_function() const {
+  try {
+    return ScoreFunction::create_expression(expression_->text().toStdString());
+  } catch (const std::invalid_argument&) {
+    return {};
+  }
+}
+
+void ExpressionWidget::validate_expression() {
+  try {
+    ScoreFunction::create_expression(expression_->text().toStdString());
+    error_->setVisible(false);
+  } catch (const std::invalid_argument& e) {
+    error_->setText(QString::fromStdString(e.what()));
+    error_->setVisible(true);
+  }
+  Q_EMIT(expression_edited());
+}
 } // namespace detail::score_function
 
 ScoreFunctionWidget::ScoreFunctionWidget(QWidget* parent): QWidget(parent), layout_(new QVBoxLayout(this)),
@@ -244,6 +288,12 @@ void ScoreFunctionWidget::set_allowed(const std::unordered_set<ScoreFunction::Ty
   if (allowed.contains(ScoreFunction::Type::weights)) {
     init_scorefunction_select_widget<detail::score_function::WeightsWidget>();
   }
+  if (allowed.contains(ScoreFunction::Type::expression)) {
+    auto* expression = init_scorefunction_select_widget<detail::score_function::ExpressionWidget>();
+    connect(expression, &detail::score_function::ExpressionWidget::expression_edited, [this]() {
+      Q_EMIT(selection_changed(ScoreFunction::Type::expression));
+    });
+  }
 
   // Adding a stretch at the end makes the items stack like a list.
   layout_->addStretch();
@@ -268,6 +318,7 @@ void ScoreFunctionWidget::set_selection(const std::optional<ScoreFunction>& sele
     widget->set_selected(selected);
     if (selected && selection.has_value()) {
       widget->set_args(selection->get_args_map());
+      widget->set_expression_text(selection->get_expression_text());
     }
   }
 }
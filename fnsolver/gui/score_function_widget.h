@@ -9,6 +9,8 @@
 #include <QRadioButton>
 #include <QDoubleSpinBox>
 #include <QButtonGroup>
+#include <QLabel>
+#include <QLineEdit>
 #include "description_widget.h"
 #include "QObjectDeleter.h"
 #include "fnsolver/solver/score_function.h"
@@ -28,6 +30,8 @@ class ScoreFunctionSelectWidget : public QWidget {
 
   virtual void set_args(const ScoreFunction::args_map_t&) {}
 
+  virtual void set_expression_text(const std::string&) {}
+
   bool is_selected() const;
   [[nodiscard]] virtual std::optional<ScoreFunction> get_score_function() const = 0;
   virtual std::optional<ScoreFunction::Type> get_score_function_type() const = 0;
@@ -149,6 +153,30 @@ class WeightsWidget : public ScoreFunctionSelectWidget {
   QDoubleSpinBox* revenue_weight_;
   QDoubleSpinBox* storage_weight_;
 };
+
+class ExpressionWidget : public ScoreFunctionSelectWidget {
+  Q_OBJECT
+
+public:
+  explicit ExpressionWidget(ScoreFunctionWidget* parent = nullptr);
+  void set_expression_text(const std::string& expression_text) override;
+  /** Empty if the expression does not parse. */
+  [[nodiscard]] std::optional<ScoreFunction> get_score_function() const override;
+
+  std::optional<ScoreFunction::Type> get_score_function_type() const override {
+    return ScoreFunction::Type::expression;
+  }
+
+Q_SIGNALS:
+  void expression_edited();
+
+private:
+  QLineEdit* expression_;
+  QLabel* error_;
+
+private Q_SLOTS:
+  void validate_expression();
+};
 } // namespace detail
 
 template <class T>
@@ -181,7 +209,7 @@ class ScoreFunctionWidget : public QWidget {
   std::vector<std::unique_ptr<detail::score_function::ScoreFunctionSelectWidget, QObjectDeleter>> widgets_;
 
   template <ScoreFunctionSelectWidget Widget_T>
-  void init_scorefunction_select_widget() {
+  Widget_T* init_scorefunction_select_widget() {
     auto& widget = widgets_.emplace_back(new Widget_T(this));
     const auto scorefunction_type = widget->get_score_function_type();
     button_group_->addButton(widget->radio_button());
@@ -189,6 +217,7 @@ class ScoreFunctionWidget : public QWidget {
     connect(widget->radio_button(), &QRadioButton::toggled, [this, scorefunction_type]() {
       Q_EMIT(selection_changed(scorefunction_type));
     });
+    return static_cast<Widget_T*>(widget.get());
   }
 };
 
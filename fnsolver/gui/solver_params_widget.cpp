@@ -188,6 +188,20 @@ resources.
   set_markdown_tooltip(widgets_.threads, threads_desc);
   set_markdown_tooltip(layout->labelForField(widgets_.threads), threads_desc);
 
+  // Share best
+  widgets_.share_best = new QCheckBox(this);
+  widgets_.share_best->setChecked(solver_options->get_share_best());
+  layout->addRow(tr("Share Best"), widgets_.share_best);
+  const auto share_best_desc = tr(R"(
+Lets threads age FrontierNav layouts against improvements other threads found earlier in the same iteration, rather
+than against the best FrontierNav layout as of the start of the iteration.
+
+This may converge faster with many threads, but results then depend on thread timing, so runs are no longer
+reproducible with an RNG seed.
+)");
+  set_markdown_tooltip(widgets_.share_best, share_best_desc);
+  set_markdown_tooltip(layout->labelForField(widgets_.share_best), share_best_desc);
+
   // Defaults
   auto* defaults_button = new QPushButton(tr("Use Defaults"), this);
   layout->addRow(defaults_button);
@@ -211,6 +225,7 @@ void SolverParamsWidget::apply_to_options(Options* options) const {
   options->set_mutation_rate(widgets_.mutation_rate->value());
   options->set_max_age(widgets_.max_age->value());
   options->set_num_threads(widgets_.threads->value());
+  options->set_share_best(widgets_.share_best->isChecked());
 }
 
 void SolverParamsWidget::use_defaults() {
@@ -224,6 +239,7 @@ void SolverParamsWidget::use_defaults() {
   widgets_.mutation_rate->setValue(defaults.get_mutation_rate());
   widgets_.max_age->setValue(defaults.get_max_age());
   widgets_.threads->setValue(defaults.get_num_threads());
+  widgets_.share_best->setChecked(defaults.get_share_best());
 }
 
 void SolverParamsWidget::seed_toggled(bool checked) {
@@ -28,6 +28,7 @@ class SolverParamsWidget : public AbstractSolverOptionsWidget {
     QDoubleSpinBox* mutation_rate;
     QSpinBox* max_age;
     QSpinBox* threads;
+    QCheckBox* share_best;
   };
 
   Widgets widgets_;
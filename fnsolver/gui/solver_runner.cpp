@@ -31,6 +31,6 @@ void SolverRunner::run() {
   auto stop_callback = [this]() {
     return isInterruptionRequested();
   };
-  const Solution solution = solver.run(progress_callback, stop_callback);
-  Q_EMIT(solved(solution.get_layout()));
+  solver.run(progress_callback, stop_callback);
+  Q_EMIT(solved(solver.get_best_snapshot()->layout));
 }
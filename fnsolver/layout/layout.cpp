@@ -4,7 +4,9 @@
 #include <fnsolver/data/precious_resource.h>
 #include <fnsolver/data/probe.h>
 #include <fnsolver/data/resource_yield.h>
+#include <fnsolver/layout/layout_evaluator.h>
 #include <fnsolver/layout/placement.h>
+#include <fnsolver/layout/reference_resolution.h>
 #include <fnsolver/layout/resolved_placement.h>
 #include <fnsolver/util/output.hpp>
 
@@ -17,175 +19,73 @@
 #include <numeric>
 #include <optional>
 #include <ostream>
+#include <span>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace {
-std::pair<std::vector<std::vector<const Probe *>>, std::vector<std::vector<uint32_t>>>
-resolve_probes_and_outgoing_boost_factors(const std::vector<Placement> &placements) {
-  std::vector<std::vector<const Probe *>> resolved_probes;
-  std::vector<std::vector<uint32_t>> resolved_outgoing_boost_factors;
-  for (const Placement &placement : placements) {
-    const Probe &probe = placement.get_probe();
-
-    std::vector<const Probe *> site_probes = {&probe};
-    std::vector<uint32_t> site_outgoing_boost_factors;
-    switch (probe.probe_type) {
-    case Probe::Type::duplicator:
-      for (const size_t neighbor_idx : placement.get_site().neighbor_idxs) {
-        const Probe &neighbor_probe = placements[neighbor_idx].get_probe();
-        site_probes.push_back(&neighbor_probe);
-        if (neighbor_probe.probe_type == Probe::Type::booster) {
-          site_outgoing_boost_factors.push_back(100 + neighbor_probe.boost_bonus);
-        }
-      }
-      break;
-    case Probe::Type::booster:
-      site_outgoing_boost_factors.push_back(100 + probe.boost_bonus);
-      break;
-    default:
-      // no-op
-      break;
-    }
-
-    resolved_probes.emplace_back(std::move(site_probes));
-    resolved_outgoing_boost_factors.emplace_back(std::move(site_outgoing_boost_factors));
-  }
-
-  return {std::move(resolved_probes), std::move(resolved_outgoing_boost_factors)};
-}
-
-struct ChainResolutionContext {
-  size_t site_idx;
-  size_t prev_site_idx;
-  size_t prev_chain_idx;
-
-  ChainResolutionContext(size_t site_idx, size_t prev_site_idx, size_t prev_chain_idx)
-      : site_idx(site_idx), prev_site_idx(prev_site_idx), prev_chain_idx(prev_chain_idx) {}
-
-  ChainResolutionContext(const ChainResolutionContext &other) = delete;
-  ChainResolutionContext(ChainResolutionContext &&other) = default;
-  ChainResolutionContext &operator=(const ChainResolutionContext &other) = delete;
-  ChainResolutionContext &operator=(ChainResolutionContext &&other) = delete;
-};
-
-std::vector<uint32_t> resolve_chain_bonuses(const std::vector<Placement> &placements) {
-  const size_t start_idx = FnSite::idx_for_id.at(111); // most central node, probably doesn't matter though
-  const size_t none_idx = FnSite::sites.size();
-
-  std::vector<ChainResolutionContext> context_stack;
-  context_stack.emplace_back(start_idx, none_idx, none_idx);
-
-  std::vector<std::vector<size_t>> chains;
-  while (!context_stack.empty()) {
-    const ChainResolutionContext context = std::move(context_stack.back());
-    context_stack.pop_back();
-
-    const size_t site_idx = context.site_idx;
-    const size_t prev_site_idx = context.prev_site_idx;
-
+std::vector<ResolvedPlacement> resolve_placements(
+    const std::vector<Placement> &placements,
+    const LayoutEvaluator &evaluator) {
+  std::vector<ResolvedPlacement> resolved_placements;
+  for (size_t site_idx = 0; site_idx < placements.size(); ++site_idx) {
     const Placement &placement = placements[site_idx];
 
-    size_t chain_idx = context.prev_chain_idx;
-    if (prev_site_idx == none_idx || &placement.get_probe() != &placements[prev_site_idx].get_probe()) {
-      chains.emplace_back();
-      chain_idx = chains.size() - 1;
-    }
-    chains[chain_idx].push_back(site_idx);
-
-    for (const size_t neighbor_idx : placement.get_site().neighbor_idxs) {
-      if (neighbor_idx != prev_site_idx) {
-        context_stack.emplace_back(neighbor_idx, site_idx, chain_idx);
+    std::vector<const Probe *> site_probes = {&placement.get_probe()};
+    if (placement.get_probe().probe_type == Probe::Type::duplicator) {
+      for (const size_t neighbor_idx : placement.get_site().neighbor_idxs) {
+        site_probes.push_back(&placements[neighbor_idx].get_probe());
       }
     }
-  }
 
-  std::vector<uint32_t> resolved_chain_bonuses(placements.size(), 0);
-  for (const std::vector<size_t> &chain : chains) {
-    uint32_t chain_bonus = 0;
-    const Probe &chain_probe = placements[chain[0]].get_probe();
-    if (chain_probe.probe_type != Probe::Type::none && chain_probe.probe_type != Probe::Type::basic) {
-      const size_t chain_len = chain.size();
-      if (chain_len >= 8) {
-        chain_bonus = 80;
-      } else if (chain_len >= 5) {
-        chain_bonus = 50;
-      } else if (chain_len >= 3) {
-        chain_bonus = 30;
-      }
-    }
+    const std::span<const uint32_t> outgoing_boost_factors = evaluator.get_outgoing_boost_factors(site_idx);
 
-    for (const size_t site_idx : chain) {
-      resolved_chain_bonuses[site_idx] = chain_bonus;
-    }
-  }
-
-  return resolved_chain_bonuses;
-}
-
-std::vector<std::vector<std::pair<std::vector<uint32_t>, uint32_t>>> resolve_incoming_boost_factors(
-    const std::vector<Placement> &placements,
-    const std::vector<std::vector<uint32_t>> &resolved_outgoing_boost_factors,
-    const std::vector<uint32_t> &resolved_chain_bonuses) {
-  std::vector<std::vector<std::pair<std::vector<uint32_t>, uint32_t>>> resolved_incoming_boost_factors;
-  for (const Placement &placement : placements) {
     std::vector<std::pair<std::vector<uint32_t>, uint32_t>> site_incoming_boost_factors;
     for (const size_t neighbor_idx : placement.get_site().neighbor_idxs) {
-      const std::vector<uint32_t> &neighbor_outgoing_boost_factors = resolved_outgoing_boost_factors[neighbor_idx];
+      const std::span<const uint32_t> neighbor_outgoing_boost_factors
+          = evaluator.get_outgoing_boost_factors(neighbor_idx);
       if (!neighbor_outgoing_boost_factors.empty()) {
         site_incoming_boost_factors.emplace_back(
-            neighbor_outgoing_boost_factors, resolved_chain_bonuses[neighbor_idx]);
+            std::vector<uint32_t>(neighbor_outgoing_boost_factors.begin(), neighbor_outgoing_boost_factors.end()),
+            evaluator.get_chain_bonus(neighbor_idx));
       }
     }
 
-    resolved_incoming_boost_factors.emplace_back(std::move(site_incoming_boost_factors));
-  }
-
-  return resolved_incoming_boost_factors;
-}
-
-std::vector<ResolvedPlacement> resolve_placements(const std::vector<Placement> &placements) {
-  auto [resolved_probes, resolved_outgoing_boost_factors] = resolve_probes_and_outgoing_boost_factors(placements);
-  std::vector<uint32_t> resolved_chain_bonuses = resolve_chain_bonuses(placements);
-  std::vector<std::vector<std::pair<std::vector<uint32_t>, uint32_t>>> resolved_incoming_boost_factors
-      = resolve_incoming_boost_factors(placements, resolved_outgoing_boost_factors, resolved_chain_bonuses);
-
-  std::vector<ResolvedPlacement> resolved_placements;
-  for (size_t site_idx = 0; site_idx < placements.size(); ++site_idx) {
     resolved_placements.emplace_back(
-        placements[site_idx].get_site(),
-        std::move(resolved_probes[site_idx]),
-        std::move(resolved_chain_bonuses[site_idx]),
-        std::move(resolved_outgoing_boost_factors[site_idx]),
-        std::move(resolved_incoming_boost_factors[site_idx]));
+        placement.get_site(),
+        std::move(site_probes),
+        evaluator.get_chain_bonus(site_idx),
+        std::vector<uint32_t>(outgoing_boost_factors.begin(), outgoing_boost_factors.end()),
+        std::move(site_incoming_boost_factors));
   }
 
   return resolved_placements;
 }
 
-ResourceYield resolve_resource_yield(const std::vector<ResolvedPlacement>& resolved_placements) {
-  uint32_t production = 0;
-  uint32_t revenue = 0;
-  uint32_t storage = 6000;
-  std::array<uint32_t, precious_resource::count> precious_resource_quantities;
-  precious_resource_quantities.fill(0);
-  for (const ResolvedPlacement& resolved_placement : resolved_placements) {
-    const ResourceYield& site_resource_yield = resolved_placement.get_resource_yield();
-    production += site_resource_yield.get_production();
-    revenue += site_resource_yield.get_revenue();
-    storage += site_resource_yield.get_storage();
-    std::transform(
-      precious_resource_quantities.cbegin(),
-      precious_resource_quantities.cend(),
-      site_resource_yield.get_precious_resource_quantities().cbegin(),
-      precious_resource_quantities.begin(),
-      [](uint32_t lhs, uint32_t rhs) { return lhs + rhs; });
+#ifdef FNSOLVER_VERIFY_EVALUATION
+/** Throws if the evaluator disagrees with the reference resolution, which shares none of its code. */
+void verify_evaluation(const std::vector<Placement> &placements, const ResourceYield &resource_yield) {
+  const ResourceYield reference_yield
+      = reference_resolution::resolve_resource_yield(reference_resolution::resolve_placements(placements));
+  if (reference_yield.get_production() != resource_yield.get_production()
+      || reference_yield.get_revenue() != resource_yield.get_revenue()
+      || reference_yield.get_storage() != resource_yield.get_storage()
+      || reference_yield.get_precious_resource_quantities() != resource_yield.get_precious_resource_quantities()) {
+    throw std::logic_error(std::format(
+        "Layout evaluation mismatch: evaluated {}/{}/{}, resolved {}/{}/{}",
+        resource_yield.get_production(),
+        resource_yield.get_revenue(),
+        resource_yield.get_storage(),
+        reference_yield.get_production(),
+        reference_yield.get_revenue(),
+        reference_yield.get_storage()));
   }
-  return ResourceYield(production, revenue, storage, std::move(precious_resource_quantities));
 }
+#endif
 } // namespace
 
 // static
@@ -235,15 +135,26 @@ std::optional<Layout> Layout::from_frontier_nav_net_url(const std::string &url)
 
 Layout::Layout(std::vector<Placement> placements)
     : placements(std::move(placements)),
-      resolved_placements(resolve_placements(this->placements)),
-    resource_yield(resolve_resource_yield(this->resolved_placements)) {}
+      evaluator([this]() {
+        LayoutEvaluator evaluator;
+        evaluator.evaluate(this->placements);
+        return evaluator;
+      }()),
+      resource_yield(evaluator.get_resource_yield()) {
+#ifdef FNSOLVER_VERIFY_EVALUATION
+  verify_evaluation(this->placements, resource_yield);
+#endif
+}
 
 const std::vector<Placement> &Layout::get_placements() const {
   return placements;
 }
 
 const std::vector<ResolvedPlacement> &Layout::get_resolved_placements() const {
-  return resolved_placements;
+  if (!resolved_placements) {
+    resolved_placements = resolve_placements(placements, evaluator);
+  }
+  return *resolved_placements;
 }
 
 const ResourceYield &Layout::get_resource_yield() const {
@@ -415,7 +326,7 @@ void Layout::output_report(
       }
       prev_site_id = site_id;
 
-      const ResolvedPlacement &resolved_placement = resolved_placements.at(site_idx);
+      const ResolvedPlacement &resolved_placement = get_resolved_placements().at(site_idx);
 
       const std::string outgoing_boost_factor_str = [&]() {
         if (!resolved_placement.get_outgoing_boost_factors().empty()) {
@@ -3,6 +3,7 @@
 
 #include <fnsolver/data/probe.h>
 #include <fnsolver/data/resource_yield.h>
+#include <fnsolver/layout/layout_evaluator.h>
 #include <fnsolver/layout/placement.h>
 #include <fnsolver/layout/resolved_placement.h>
 
@@ -25,7 +26,10 @@ class Layout {
 
     /** Site/Probe pairs ordered by site id */
     const std::vector<Placement> &get_placements() const;
-    /** Site yield info ordered by site id */
+    /**
+     * Site yield info ordered by site id. Only the resource yield is resolved while solving, the per-site details are
+     * built on first call, so the first call must not race with another.
+     */
     const std::vector<ResolvedPlacement> &get_resolved_placements() const;
     const ResourceYield &get_resource_yield() const;
 
@@ -39,8 +43,9 @@ class Layout {
         bool output_site_details) const;
   private:
     std::vector<Placement> placements;
+    LayoutEvaluator evaluator;
 
-    std::vector<ResolvedPlacement> resolved_placements;
+    mutable std::optional<std::vector<ResolvedPlacement>> resolved_placements;
     ResourceYield resource_yield;
 };
 
@@ -0,0 +1,540 @@
+#include <fnsolver/layout/layout_evaluator.h>
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/site_mask.h>
+#include <fnsolver/data/site_topology.h>
+#include <fnsolver/data/yield_table.h>
+#include <fnsolver/layout/placement.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+/** Random key per (site idx, probe idx), a layout's hash is the xor of the keys of its placements */
+constexpr std::array<std::array<uint64_t, Probe::num_probes>, FnSite::num_sites> zobrist_keys = []() {
+  std::array<std::array<uint64_t, Probe::num_probes>, FnSite::num_sites> keys;
+  uint64_t state = 0x9e3779b97f4a7c15; // splitmix64, fixed seed so hashes are stable between runs
+  for (std::array<uint64_t, Probe::num_probes> &site_keys : keys) {
+    for (uint64_t &key : site_keys) {
+      state += 0x9e3779b97f4a7c15;
+      key = state;
+      key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9;
+      key = (key ^ (key >> 27)) * 0x94d049bb133111eb;
+      key = key ^ (key >> 31);
+    }
+  }
+  return keys;
+}();
+
+/** Only visits the set sites, each row being a handful of lanes that the default build already adds as vectors */
+void sum_precious_resource_quantities(
+    const SiteMask &sites,
+    std::array<uint32_t, precious_resource::count> &precious_resource_quantities) {
+  const std::array<std::array<uint32_t, precious_resource::count>, FnSite::num_sites> &site_quantities
+      = SiteTopology::get().get_precious_resource_quantities();
+  precious_resource_quantities.fill(0);
+  sites.for_each([&](size_t site_idx) {
+    for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+      precious_resource_quantities[precious_resource_idx] += site_quantities[site_idx][precious_resource_idx];
+    }
+  });
+}
+
+using outgoing_boost_factors_t = std::array<uint32_t, LayoutEvaluator::max_outgoing_boost_factors>;
+
+/** The chain (connected sites holding the same probe) containing site_idx, probe_sites being the sites with its probe */
+SiteMask chain_containing(size_t site_idx, const SiteMask &probe_sites) {
+  // Flood fill outwards from site_idx, a whole frontier at a time, restricted to the sites holding the same probe.
+  const SiteTopology &topology = SiteTopology::get();
+  SiteMask chain = SiteMask::single(site_idx);
+  SiteMask frontier = chain;
+  while (!frontier.none()) {
+    SiteMask expanded;
+    frontier.for_each([&](size_t frontier_idx) { expanded |= topology.get_neighbor_mask(frontier_idx); });
+    frontier = expanded & probe_sites & ~chain;
+    chain |= frontier;
+  }
+  return chain;
+}
+
+SiteMask neighbors_of(const SiteMask &sites) {
+  const SiteTopology &topology = SiteTopology::get();
+  SiteMask neighbors;
+  sites.for_each([&](size_t site_idx) { neighbors |= topology.get_neighbor_mask(site_idx); });
+  return neighbors;
+}
+
+/** Resolves the boost factors site_idx applies to its neighbors into factors, returns how many there are. */
+uint32_t outgoing_boost_factors_for(
+    size_t site_idx,
+    const LayoutEvaluator::probe_idxs_t &probe_idxs,
+    outgoing_boost_factors_t &factors) {
+  const Probe &probe = Probe::probes[probe_idxs[site_idx]];
+
+  uint32_t num_factors = 0;
+  switch (probe.probe_type) {
+  case Probe::Type::duplicator:
+    for (const size_t neighbor_idx : SiteTopology::get().neighbors(site_idx)) {
+      const Probe &neighbor_probe = Probe::probes[probe_idxs[neighbor_idx]];
+      if (neighbor_probe.probe_type == Probe::Type::booster) {
+        factors[num_factors++] = 100 + neighbor_probe.boost_bonus;
+      }
+    }
+    break;
+  case Probe::Type::booster:
+    factors[num_factors++] = 100 + probe.boost_bonus;
+    break;
+  default:
+    // no-op
+    break;
+  }
+  return num_factors;
+}
+
+/** Production, revenue, and storage of site_idx, given the chain bonuses and outgoing boost factors of every site. */
+std::array<uint32_t, 3> site_resource_yield_for(
+    size_t site_idx,
+    const LayoutEvaluator::probe_idxs_t &probe_idxs,
+    const std::array<uint32_t, FnSite::num_sites> &chain_bonuses,
+    const std::array<uint32_t, FnSite::num_sites> &num_outgoing_boost_factors,
+    const std::array<outgoing_boost_factors_t, FnSite::num_sites> &outgoing_boost_factors) {
+  const SiteTopology &topology = SiteTopology::get();
+  const YieldTable &yield_table = YieldTable::get();
+
+  const auto apply_incoming_boost_factors = [&](uint32_t value) {
+    for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+      const uint32_t num_factors = num_outgoing_boost_factors[neighbor_idx];
+      if (num_factors == 0) {
+        continue;
+      }
+
+      for (uint32_t factor_idx = 0; factor_idx < num_factors; ++factor_idx) {
+        value = value * outgoing_boost_factors[neighbor_idx][factor_idx] / 100;
+      }
+      value = value * (100 + chain_bonuses[neighbor_idx]) / 100;
+    }
+    return value;
+  };
+
+  std::array<uint32_t, 3> yields = {0, 0, 0};
+  const auto add_probe = [&](size_t probe_idx) {
+    const YieldTable::Entry &entry = yield_table.entry(site_idx, probe_idx);
+    yields[YieldTable::production] += entry.unboosted[YieldTable::production];
+    yields[YieldTable::revenue] += entry.unboosted[YieldTable::revenue];
+    yields[YieldTable::storage] += entry.unboosted[YieldTable::storage];
+    if (entry.boostable != 0) {
+      yields[entry.boosted_yield]
+          += apply_incoming_boost_factors(entry.boostable * (100 + chain_bonuses[site_idx]) / 100);
+    }
+  };
+
+  add_probe(probe_idxs[site_idx]);
+  if (Probe::probes[probe_idxs[site_idx]].probe_type == Probe::Type::duplicator) {
+    for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+      add_probe(probe_idxs[neighbor_idx]);
+    }
+  }
+
+  yields[YieldTable::revenue] /= 2;
+  return yields;
+}
+
+/** Patches precious_resource_quantities for site_idx going from old_probe_idx to new_probe_idx. */
+void update_precious_resource_quantities(
+    size_t site_idx,
+    size_t old_probe_idx,
+    size_t new_probe_idx,
+    std::array<uint32_t, precious_resource::count> &precious_resource_quantities) {
+  const bool old_collects = LayoutEvaluator::collects_precious_resources(old_probe_idx);
+  if (old_collects == LayoutEvaluator::collects_precious_resources(new_probe_idx)) {
+    return;
+  }
+
+  const std::array<uint32_t, precious_resource::count> &site_quantities
+      = SiteTopology::get().get_precious_resource_quantities()[site_idx];
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    if (old_collects) {
+      precious_resource_quantities[precious_resource_idx] -= site_quantities[precious_resource_idx];
+    } else {
+      precious_resource_quantities[precious_resource_idx] += site_quantities[precious_resource_idx];
+    }
+  }
+}
+} // namespace
+
+// static
+bool LayoutEvaluator::collects_precious_resources(size_t probe_idx) {
+  const Probe::Type probe_type = Probe::probes[probe_idx].probe_type;
+  return probe_type == Probe::Type::basic || probe_type == Probe::Type::mining;
+}
+
+// static
+uint32_t LayoutEvaluator::chain_bonus_for_length(const Probe &chain_probe, size_t chain_len) {
+  if (chain_probe.probe_type == Probe::Type::none || chain_probe.probe_type == Probe::Type::basic) {
+    return 0;
+  }
+
+  if (chain_len >= 8) {
+    return 80;
+  } else if (chain_len >= 5) {
+    return 50;
+  } else if (chain_len >= 3) {
+    return 30;
+  }
+  return 0;
+}
+
+// static
+LayoutEvaluator::probe_idxs_t LayoutEvaluator::probe_idxs_for(const std::vector<Placement> &placements) {
+  probe_idxs_t probe_idxs;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    probe_idxs[site_idx] = static_cast<probe_idx_t>(placements[site_idx].get_probe().probe_id);
+  }
+  return probe_idxs;
+}
+
+void LayoutEvaluator::evaluate(const probe_idxs_t &probe_idxs) {
+  this->probe_idxs = probe_idxs;
+  hash = 0;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    hash ^= zobrist_keys[site_idx][probe_idxs[site_idx]];
+  }
+  resolve_probe_site_masks();
+
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    resolve_outgoing_boost_factors(site_idx);
+  }
+  resolve_chain_bonuses();
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    resolve_site_resource_yield(site_idx);
+  }
+  resolve_resource_yield();
+}
+
+void LayoutEvaluator::reevaluate(const probe_idxs_t &probe_idxs, std::span<const size_t> changed_site_idxs) {
+  std::array<bool, FnSite::num_sites> changed;
+  changed.fill(false);
+  for (const size_t site_idx : changed_site_idxs) {
+    if (this->probe_idxs[site_idx] != probe_idxs[site_idx]) {
+      changed[site_idx] = true;
+    }
+  }
+
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (changed[site_idx]) {
+      update_precious_resource_quantities(
+          site_idx,
+          this->probe_idxs[site_idx],
+          probe_idxs[site_idx],
+          precious_resource_quantities);
+      hash ^= zobrist_keys[site_idx][this->probe_idxs[site_idx]] ^ zobrist_keys[site_idx][probe_idxs[site_idx]];
+      probe_site_masks[this->probe_idxs[site_idx]].reset(site_idx);
+      this->probe_idxs[site_idx] = probe_idxs[site_idx];
+      probe_site_masks[this->probe_idxs[site_idx]].set(site_idx);
+    }
+  }
+
+  // Sites whose own chain bonus or outgoing boost factors may have changed are the changed sites and their neighbors.
+  // Any chain that gained or lost a site necessarily contains one of them, and only duplicators depend on neighbors.
+  const SiteTopology &topology = SiteTopology::get();
+  std::array<bool, FnSite::num_sites> touched = changed;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (changed[site_idx]) {
+      for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+        touched[neighbor_idx] = true;
+      }
+    }
+  }
+
+  // Sites that boost their neighbors differently than before.
+  std::array<bool, FnSite::num_sites> boost_changed;
+  boost_changed.fill(false);
+  std::array<bool, FnSite::num_sites> needs_yield = changed;
+
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (!touched[site_idx]) {
+      continue;
+    }
+
+    const uint32_t old_num_factors = num_outgoing_boost_factors[site_idx];
+    const std::array<uint32_t, max_outgoing_boost_factors> old_factors = outgoing_boost_factors[site_idx];
+    resolve_outgoing_boost_factors(site_idx);
+    if (num_outgoing_boost_factors[site_idx] != old_num_factors
+        || !std::equal(
+            old_factors.cbegin(),
+            old_factors.cbegin() + old_num_factors,
+            outgoing_boost_factors[site_idx].cbegin())) {
+      boost_changed[site_idx] = true;
+    }
+
+    // A duplicator copies its neighbors' probes, so its own yield changes with theirs.
+    if (Probe::probes[this->probe_idxs[site_idx]].probe_type == Probe::Type::duplicator) {
+      needs_yield[site_idx] = true;
+    }
+  }
+
+  SiteMask resolved;
+  for (size_t start_idx = 0; start_idx < FnSite::num_sites; ++start_idx) {
+    if (!touched[start_idx] || resolved.test(start_idx)) {
+      continue;
+    }
+
+    const SiteMask chain = chain_containing(start_idx, probe_site_masks[this->probe_idxs[start_idx]]);
+    resolved |= chain;
+    const uint32_t chain_bonus = chain_bonus_for_length(Probe::probes[this->probe_idxs[start_idx]], chain.count());
+    chain.for_each([&](size_t site_idx) {
+      if (chain_bonuses[site_idx] != chain_bonus) {
+        chain_bonuses[site_idx] = chain_bonus;
+        needs_yield[site_idx] = true;
+        if (num_outgoing_boost_factors[site_idx] != 0) {
+          boost_changed[site_idx] = true;
+        }
+      }
+    });
+  }
+
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (boost_changed[site_idx]) {
+      for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+        needs_yield[neighbor_idx] = true;
+      }
+    }
+  }
+
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (needs_yield[site_idx]) {
+      production -= site_productions[site_idx];
+      revenue -= site_revenues[site_idx];
+      storage -= site_storages[site_idx];
+      resolve_site_resource_yield(site_idx);
+      production += site_productions[site_idx];
+      revenue += site_revenues[site_idx];
+      storage += site_storages[site_idx];
+    }
+  }
+
+#ifdef FNSOLVER_VERIFY_EVALUATION
+  LayoutEvaluator full_evaluator;
+  full_evaluator.evaluate(probe_idxs);
+  if (full_evaluator.production != production
+      || full_evaluator.revenue != revenue
+      || full_evaluator.storage != storage
+      || full_evaluator.precious_resource_quantities != precious_resource_quantities
+      || full_evaluator.hash != hash) {
+    throw std::logic_error(std::format(
+        "Incremental layout evaluation mismatch: reevaluated {}/{}/{}, evaluated {}/{}/{}",
+        production,
+        revenue,
+        storage,
+        full_evaluator.production,
+        full_evaluator.revenue,
+        full_evaluator.storage));
+  }
+#endif
+}
+
+void LayoutEvaluator::evaluate(const std::vector<Placement> &placements) {
+  evaluate(probe_idxs_for(placements));
+}
+
+const LayoutEvaluator::probe_idxs_t &LayoutEvaluator::get_probe_idxs() const {
+  return probe_idxs;
+}
+
+uint32_t LayoutEvaluator::get_chain_bonus(size_t site_idx) const {
+  return chain_bonuses[site_idx];
+}
+
+std::span<const uint32_t> LayoutEvaluator::get_outgoing_boost_factors(size_t site_idx) const {
+  return std::span<const uint32_t>(outgoing_boost_factors[site_idx].data(), num_outgoing_boost_factors[site_idx]);
+}
+
+uint32_t LayoutEvaluator::get_site_production(size_t site_idx) const {
+  return site_productions[site_idx];
+}
+
+uint32_t LayoutEvaluator::get_site_revenue(size_t site_idx) const {
+  return site_revenues[site_idx];
+}
+
+uint32_t LayoutEvaluator::get_site_storage(size_t site_idx) const {
+  return site_storages[site_idx];
+}
+
+uint32_t LayoutEvaluator::get_production() const {
+  return production;
+}
+
+uint32_t LayoutEvaluator::get_revenue() const {
+  return revenue;
+}
+
+uint32_t LayoutEvaluator::get_storage() const {
+  return storage;
+}
+
+uint64_t LayoutEvaluator::get_hash() const {
+  return hash;
+}
+
+uint64_t LayoutEvaluator::get_hash_for(const probe_idxs_t &probe_idxs, std::span<const size_t> changed_site_idxs) const {
+  uint64_t new_hash = hash;
+  for (const size_t site_idx : changed_site_idxs) {
+    new_hash ^= zobrist_keys[site_idx][this->probe_idxs[site_idx]] ^ zobrist_keys[site_idx][probe_idxs[site_idx]];
+  }
+  return new_hash;
+}
+
+const std::array<uint32_t, precious_resource::count> &LayoutEvaluator::get_precious_resource_quantities() const {
+  return precious_resource_quantities;
+}
+
+std::array<uint32_t, precious_resource::count> LayoutEvaluator::get_precious_resource_quantities_for(
+    const probe_idxs_t &probe_idxs,
+    std::span<const size_t> changed_site_idxs) const {
+  std::array<uint32_t, precious_resource::count> quantities = precious_resource_quantities;
+  for (const size_t site_idx : changed_site_idxs) {
+    update_precious_resource_quantities(site_idx, this->probe_idxs[site_idx], probe_idxs[site_idx], quantities);
+  }
+  return quantities;
+}
+
+ResourceYield LayoutEvaluator::get_resource_yield() const {
+  return ResourceYield(production, revenue, storage, precious_resource_quantities);
+}
+
+ResourceYield LayoutEvaluator::get_resource_yield_bound_for(
+    const probe_idxs_t &probe_idxs,
+    std::span<const size_t> changed_site_idxs) const {
+  SiteMask changed;
+  std::array<SiteMask, Probe::num_probes> new_probe_site_masks = probe_site_masks;
+  for (const size_t site_idx : changed_site_idxs) {
+    if (this->probe_idxs[site_idx] != probe_idxs[site_idx]) {
+      changed.set(site_idx);
+      new_probe_site_masks[this->probe_idxs[site_idx]].reset(site_idx);
+      new_probe_site_masks[probe_idxs[site_idx]].set(site_idx);
+    }
+  }
+
+  // Only a chain containing a changed site can have grown. Every other chain kept or lost sites, so the current bonus
+  // is an upper bound for it, and yields never decrease as a chain bonus increases.
+  std::array<uint32_t, FnSite::num_sites> bound_chain_bonuses = chain_bonuses;
+  SiteMask grown;
+  changed.for_each([&](size_t site_idx) {
+    if (grown.test(site_idx)) {
+      return;
+    }
+
+    const SiteMask chain = chain_containing(site_idx, new_probe_site_masks[probe_idxs[site_idx]]);
+    grown |= chain;
+    const uint32_t chain_bonus = chain_bonus_for_length(Probe::probes[probe_idxs[site_idx]], chain.count());
+    chain.for_each([&](size_t chain_site_idx) { bound_chain_bonuses[chain_site_idx] = chain_bonus; });
+  });
+
+  // Outgoing boost factors only depend on a site's own probe, and a duplicator's neighbors.
+  const SiteMask changed_neighborhood = changed | neighbors_of(changed);
+  std::array<uint32_t, FnSite::num_sites> new_num_outgoing_boost_factors = num_outgoing_boost_factors;
+  std::array<outgoing_boost_factors_t, FnSite::num_sites> new_outgoing_boost_factors = outgoing_boost_factors;
+  changed_neighborhood.for_each([&](size_t site_idx) {
+    new_num_outgoing_boost_factors[site_idx]
+        = outgoing_boost_factors_for(site_idx, probe_idxs, new_outgoing_boost_factors[site_idx]);
+  });
+
+  // Any site that can yield more is in, or next to, a site whose probes, chain bonus, or boosts may have changed.
+  SiteMask affected = changed_neighborhood | grown;
+  affected |= neighbors_of(affected);
+
+  uint32_t bound_production = production;
+  uint32_t bound_revenue = revenue;
+  uint32_t bound_storage = storage;
+  affected.for_each([&](size_t site_idx) {
+    const std::array<uint32_t, 3> yields = site_resource_yield_for(
+        site_idx,
+        probe_idxs,
+        bound_chain_bonuses,
+        new_num_outgoing_boost_factors,
+        new_outgoing_boost_factors);
+    bound_production += yields[YieldTable::production] - site_productions[site_idx];
+    bound_revenue += yields[YieldTable::revenue] - site_revenues[site_idx];
+    bound_storage += yields[YieldTable::storage] - site_storages[site_idx];
+  });
+
+  return ResourceYield(
+      bound_production,
+      bound_revenue,
+      bound_storage,
+      get_precious_resource_quantities_for(probe_idxs, changed_site_idxs));
+}
+
+void LayoutEvaluator::resolve_outgoing_boost_factors(size_t site_idx) {
+  num_outgoing_boost_factors[site_idx]
+      = outgoing_boost_factors_for(site_idx, probe_idxs, outgoing_boost_factors[site_idx]);
+}
+
+void LayoutEvaluator::resolve_probe_site_masks() {
+  probe_site_masks.fill(SiteMask());
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    probe_site_masks[probe_idxs[site_idx]].set(site_idx);
+  }
+}
+
+void LayoutEvaluator::resolve_chain_bonuses() {
+  chain_bonuses.fill(0);
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    const SiteMask &probe_sites = probe_site_masks[probe_idx];
+    const Probe &probe = Probe::probes[probe_idx];
+    if (chain_bonus_for_length(probe, probe_sites.count()) == 0) {
+      continue; // no chain of this probe can earn a bonus
+    }
+
+    SiteMask remaining = probe_sites;
+    while (!remaining.none()) {
+      const SiteMask chain = chain_containing(remaining.lowest(), probe_sites);
+      remaining &= ~chain;
+
+      const uint32_t chain_bonus = chain_bonus_for_length(probe, chain.count());
+      if (chain_bonus != 0) {
+        chain.for_each([&](size_t site_idx) { chain_bonuses[site_idx] = chain_bonus; });
+      }
+    }
+  }
+}
+
+void LayoutEvaluator::resolve_site_resource_yield(size_t site_idx) {
+  const std::array<uint32_t, 3> yields = site_resource_yield_for(
+      site_idx,
+      probe_idxs,
+      chain_bonuses,
+      num_outgoing_boost_factors,
+      outgoing_boost_factors);
+  site_productions[site_idx] = yields[YieldTable::production];
+  site_revenues[site_idx] = yields[YieldTable::revenue];
+  site_storages[site_idx] = yields[YieldTable::storage];
+}
+
+void LayoutEvaluator::resolve_resource_yield() {
+  production = 0;
+  revenue = 0;
+  storage = 6000;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    production += site_productions[site_idx];
+    revenue += site_revenues[site_idx];
+    storage += site_storages[site_idx];
+  }
+
+  SiteMask collecting_sites;
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    if (collects_precious_resources(probe_idx)) {
+      collecting_sites |= probe_site_masks[probe_idx];
+    }
+  }
+  sum_precious_resource_quantities(collecting_sites, precious_resource_quantities);
+}
@@ -0,0 +1,115 @@
+#ifndef FNSOLVER_LAYOUT_LAYOUT_EVALUATOR_H
+#define FNSOLVER_LAYOUT_LAYOUT_EVALUATOR_H
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/site_mask.h>
+#include <fnsolver/layout/placement.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * Fixed-size, structure-of-arrays evaluator for a full layout.
+ *
+ * Resolves the same chain bonuses, boost factors, and resource yields as the per-site ResolvedPlacement pipeline, but
+ * keeps all of its state in arrays sized to FnSite::num_sites, so that evaluating a layout never touches the heap. An
+ * instance may be reused for any number of evaluations.
+ */
+class LayoutEvaluator {
+  public:
+    using probe_idx_t = uint8_t;
+    using probe_idxs_t = std::array<probe_idx_t, FnSite::num_sites>;
+
+    /** A duplicator copies at most one booster per neighbor. */
+    static constexpr size_t max_outgoing_boost_factors = 4;
+
+    /** Whether a site holding the probe collects its precious resources, which is all they depend on */
+    static bool collects_precious_resources(size_t probe_idx);
+    /** Percent bonus of every site in a chain of chain_len connected sites holding chain_probe */
+    static uint32_t chain_bonus_for_length(const Probe &chain_probe, size_t chain_len);
+    /** Site/Probe pairs ordered by site id, one per site */
+    static probe_idxs_t probe_idxs_for(const std::vector<Placement> &placements);
+
+    LayoutEvaluator() = default;
+
+    LayoutEvaluator(const LayoutEvaluator &other) = default;
+    LayoutEvaluator(LayoutEvaluator &&other) = default;
+    LayoutEvaluator &operator=(const LayoutEvaluator &other) = default;
+    LayoutEvaluator &operator=(LayoutEvaluator &&other) = default;
+
+    /** Probe indices (into Probe::probes) ordered by site idx */
+    void evaluate(const probe_idxs_t &probe_idxs);
+    /** Site/Probe pairs ordered by site id, one per site */
+    void evaluate(const std::vector<Placement> &placements);
+    /**
+     * Incrementally re-evaluates from the currently resolved state. probe_idxs may only differ from the current probe
+     * indices at changed_site_idxs. Only the changed sites, the chains and boost factors they touch, and the sites
+     * receiving those boosts are resolved again; the totals are patched accordingly.
+     */
+    void reevaluate(const probe_idxs_t &probe_idxs, std::span<const size_t> changed_site_idxs);
+
+    const probe_idxs_t &get_probe_idxs() const;
+    /** Zobrist hash of the probe indices, equal layouts have equal hashes */
+    uint64_t get_hash() const;
+    /**
+     * Hash of probe_idxs, which may only differ from the current probe indices at changed_site_idxs, which must not
+     * repeat.
+     */
+    uint64_t get_hash_for(const probe_idxs_t &probe_idxs, std::span<const size_t> changed_site_idxs) const;
+    uint32_t get_chain_bonus(size_t site_idx) const;
+    std::span<const uint32_t> get_outgoing_boost_factors(size_t site_idx) const;
+    uint32_t get_site_production(size_t site_idx) const;
+    uint32_t get_site_revenue(size_t site_idx) const;
+    uint32_t get_site_storage(size_t site_idx) const;
+
+    uint32_t get_production() const;
+    uint32_t get_revenue() const;
+    uint32_t get_storage() const;
+    const std::array<uint32_t, precious_resource::count> &get_precious_resource_quantities() const;
+    /**
+     * Precious resource quantities probe_idxs would collect, without evaluating it. probe_idxs may only differ from the
+     * current probe indices at changed_site_idxs, which must not repeat.
+     */
+    std::array<uint32_t, precious_resource::count> get_precious_resource_quantities_for(
+        const probe_idxs_t &probe_idxs,
+        std::span<const size_t> changed_site_idxs) const;
+    /**
+     * Upper bound on each of the production, revenue, and storage probe_idxs would yield, with exact precious resource
+     * quantities, for much less than a full evaluation. Same requirements as get_precious_resource_quantities_for().
+     */
+    ResourceYield get_resource_yield_bound_for(
+        const probe_idxs_t &probe_idxs,
+        std::span<const size_t> changed_site_idxs) const;
+    ResourceYield get_resource_yield() const;
+  private:
+    probe_idxs_t probe_idxs;
+    uint64_t hash;
+    /** Sites holding each probe, indexed like Probe::probes */
+    std::array<SiteMask, Probe::num_probes> probe_site_masks;
+
+    std::array<uint32_t, FnSite::num_sites> chain_bonuses;
+    std::array<uint32_t, FnSite::num_sites> num_outgoing_boost_factors;
+    std::array<std::array<uint32_t, max_outgoing_boost_factors>, FnSite::num_sites> outgoing_boost_factors;
+
+    std::array<uint32_t, FnSite::num_sites> site_productions;
+    std::array<uint32_t, FnSite::num_sites> site_revenues;
+    std::array<uint32_t, FnSite::num_sites> site_storages;
+
+    uint32_t production;
+    uint32_t revenue;
+    uint32_t storage;
+    std::array<uint32_t, precious_resource::count> precious_resource_quantities;
+
+    void resolve_outgoing_boost_factors(size_t site_idx);
+    void resolve_probe_site_masks();
+    void resolve_chain_bonuses();
+    void resolve_site_resource_yield(size_t site_idx);
+    void resolve_resource_yield();
+};
+
+#endif // FNSOLVER_LAYOUT_LAYOUT_EVALUATOR_H
@@ -0,0 +1,24 @@
+#ifndef FNSOLVER_LAYOUT_REFERENCE_RESOLUTION_H
+#define FNSOLVER_LAYOUT_REFERENCE_RESOLUTION_H
+
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/layout/placement.h>
+#include <fnsolver/layout/resolved_placement.h>
+
+#include <vector>
+
+/**
+ * The original per-site resolution of a layout: chains found by walking the site graph, boost factors read straight
+ * off the placements, and yields calculated by ResolvedPlacement from the sites and probes. Shares nothing with
+ * LayoutEvaluator or YieldTable, so it serves as the reference they're checked against. Slow, and allocates freely.
+ */
+namespace reference_resolution {
+
+/** Site/Probe pairs ordered by site id, one per site */
+std::vector<ResolvedPlacement> resolve_placements(const std::vector<Placement> &placements);
+/** Total of the resolved placements' yields, every layout starting out with 6000 storage */
+ResourceYield resolve_resource_yield(const std::vector<ResolvedPlacement> &resolved_placements);
+
+} // namespace reference_resolution
+
+#endif // FNSOLVER_LAYOUT_REFERENCE_RESOLUTION_H
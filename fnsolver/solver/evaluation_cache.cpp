@@ -0,0 +1,24 @@
+#include <fnsolver/solver/evaluation_cache.h>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+EvaluationCache::EvaluationCache() : entries(num_entries, Entry{false, 0, Scores{0.0, 0.0, false, false}}) {}
+
+std::optional<EvaluationCache::Scores> EvaluationCache::find(uint64_t hash) const {
+  const Entry &entry = entries[hash % num_entries];
+  if (!entry.occupied || entry.hash != hash) {
+    return {};
+  }
+  return entry.scores;
+}
+
+void EvaluationCache::insert(uint64_t hash, const Scores &scores) {
+  Entry &entry = entries[hash % num_entries];
+  if (entry.occupied && entry.hash == hash && !entry.scores.is_bound
+      && (scores.is_bound || (!scores.has_tiebreaker_score && entry.scores.has_tiebreaker_score))) {
+    return;
+  }
+  entry = Entry{true, hash, scores};
+}
@@ -0,0 +1,48 @@
+#ifndef FNSOLVER_SOLVER_EVALUATION_CACHE_H
+#define FNSOLVER_SOLVER_EVALUATION_CACHE_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * Bounded cache of layout scores, keyed by layout hash. Direct-mapped, so a new layout simply evicts whichever layout
+ * shared its slot. Not thread-safe, use one per thread.
+ */
+class EvaluationCache {
+  public:
+    static constexpr size_t num_entries = size_t(1) << 16;
+
+    struct Scores {
+      double score;
+      double tiebreaker_score;
+      /** Tiebreakers are only computed for children whose scores tie, tiebreaker_score is meaningless until then */
+      bool has_tiebreaker_score;
+      /** Whether score is only an upper bound on the actual score, tiebreaker_score is meaningless if so */
+      bool is_bound;
+    };
+
+    EvaluationCache();
+
+    EvaluationCache(const EvaluationCache &other) = default;
+    EvaluationCache(EvaluationCache &&other) = default;
+    EvaluationCache &operator=(const EvaluationCache &other) = default;
+    EvaluationCache &operator=(EvaluationCache &&other) = default;
+
+    std::optional<Scores> find(uint64_t hash) const;
+    /**
+     * A bound never replaces the actual scores of the same layout, and scores without a tiebreaker never replace the
+     * same scores with one.
+     */
+    void insert(uint64_t hash, const Scores &scores);
+  private:
+    struct Entry {
+      bool occupied;
+      uint64_t hash;
+      Scores scores;
+    };
+
+    std::vector<Entry> entries;
+};
+
+#endif // FNSOLVER_SOLVER_EVALUATION_CACHE_H
@@ -25,13 +25,17 @@ Options::Options(
     uint32_t production_minimum,
     uint32_t revenue_minimum,
     uint32_t storage_minimum,
+    ScoreFunction::ConstraintMode constraint_mode,
+    bool repair_offspring,
     uint32_t iterations,
     uint32_t bonus_iterations,
     uint32_t population_size,
     uint32_t num_offspring,
     double mutation_rate,
     uint32_t max_age,
-    uint32_t num_threads)
+    uint32_t num_threads,
+    std::optional<uint64_t> maybe_rng_seed,
+    bool share_best)
     : auto_confirm(auto_confirm),
       score_function(std::move(score_function)),
       maybe_tiebreaker_function(std::move(maybe_tiebreaker_function)),
@@ -44,13 +48,17 @@ Options::Options(
       production_minimum(production_minimum),
       revenue_minimum(revenue_minimum),
       storage_minimum(storage_minimum),
+      constraint_mode(constraint_mode),
+      repair_offspring(repair_offspring),
       iterations(iterations),
       bonus_iterations(bonus_iterations),
       population_size(population_size),
       num_offspring(num_offspring),
       mutation_rate(mutation_rate),
       max_age(max_age),
-      num_threads(num_threads) {}
+      num_threads(num_threads),
+      maybe_rng_seed(maybe_rng_seed),
+      share_best(share_best) {}
 
 bool Options::get_auto_confirm() const {
   return auto_confirm;
@@ -152,6 +160,22 @@ void Options::set_storage_minimum(uint32_t storage_minimum) {
   this->storage_minimum = storage_minimum;
 }
 
+ScoreFunction::ConstraintMode Options::get_constraint_mode() const {
+  return constraint_mode;
+}
+
+void Options::set_constraint_mode(ScoreFunction::ConstraintMode constraint_mode) {
+  this->constraint_mode = constraint_mode;
+}
+
+bool Options::get_repair_offspring() const {
+  return repair_offspring;
+}
+
+void Options::set_repair_offspring(bool repair_offspring) {
+  this->repair_offspring = repair_offspring;
+}
+
 uint32_t Options::get_iterations() const {
   return iterations;
 }
@@ -207,3 +231,19 @@ uint32_t Options::get_num_threads() const {
 void Options::set_num_threads(uint32_t num_threads) {
   this->num_threads = num_threads;
 }
+
+const std::optional<uint64_t> &Options::get_maybe_rng_seed() const {
+  return maybe_rng_seed;
+}
+
+void Options::set_maybe_rng_seed(std::optional<uint64_t> maybe_rng_seed) {
+  this->maybe_rng_seed = maybe_rng_seed;
+}
+
+bool Options::get_share_best() const {
+  return share_best;
+}
+
+void Options::set_share_best(bool share_best) {
+  this->share_best = share_best;
+}
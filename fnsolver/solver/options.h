@@ -31,13 +31,17 @@ class Options {
         uint32_t production_minimum,
         uint32_t revenue_minimum,
         uint32_t storage_minimum,
+        ScoreFunction::ConstraintMode constraint_mode,
+        bool repair_offspring,
         uint32_t iterations,
         uint32_t bonus_iterations,
         uint32_t population_size,
         uint32_t num_offspring,
         double mutation_rate,
         uint32_t max_age,
-        uint32_t num_threads);
+        uint32_t num_threads,
+        std::optional<uint64_t> maybe_rng_seed,
+        bool share_best);
 
     Options(const Options &other) = default;
     Options(Options &&other) = default;
@@ -82,6 +86,14 @@ class Options {
     uint32_t get_storage_minimum() const;
     void set_storage_minimum(uint32_t storage_minimum);
 
+    // how layouts missing any of the minimums above are scored
+    ScoreFunction::ConstraintMode get_constraint_mode() const;
+    void set_constraint_mode(ScoreFunction::ConstraintMode constraint_mode);
+
+    // whether offspring missing the precious resource minimums have probes swapped onto sites yielding them
+    bool get_repair_offspring() const;
+    void set_repair_offspring(bool repair_offspring);
+
     uint32_t get_iterations() const;
     void set_iterations(uint32_t iterations);
 
@@ -102,6 +114,14 @@ class Options {
 
     uint32_t get_num_threads() const;
     void set_num_threads(uint32_t num_threads);
+
+    // none to seed from std::random_device, otherwise the same seed gives the same result for any number of threads
+    const std::optional<uint64_t> &get_maybe_rng_seed() const;
+    void set_maybe_rng_seed(std::optional<uint64_t> maybe_rng_seed);
+
+    // whether threads see each other's improvements mid-iteration, which makes results depend on thread timing
+    bool get_share_best() const;
+    void set_share_best(bool share_best);
   private:
     bool auto_confirm;
 
@@ -119,6 +139,8 @@ class Options {
     uint32_t production_minimum;
     uint32_t revenue_minimum;
     uint32_t storage_minimum;
+    ScoreFunction::ConstraintMode constraint_mode;
+    bool repair_offspring;
 
     uint32_t iterations;
     uint32_t bonus_iterations;
@@ -127,6 +149,8 @@ class Options {
     double mutation_rate;
     uint32_t max_age;
     uint32_t num_threads;
+    std::optional<uint64_t> maybe_rng_seed;
+    bool share_best;
 };
 
 #endif // FNSOLVER_SOLVER_OPTIONS_H
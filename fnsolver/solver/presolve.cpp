@@ -0,0 +1,287 @@
+#include <fnsolver/solver/presolve.h>
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/data/site_topology.h>
+#include <fnsolver/data/yield_table.h>
+#include <fnsolver/layout/layout_evaluator.h>
+#include <fnsolver/layout/placement.h>
+#include <fnsolver/solver/options.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+namespace {
+/** Every layout starts out with this much storage, see LayoutEvaluator */
+constexpr uint64_t base_storage = 6000;
+} // namespace
+
+Presolve::Presolve(const Options &options) : infeasible(false), num_required_collecting_sites(0) {
+  maybe_fixed_probe_idxs.fill(std::nullopt);
+  mutable_probe_quantities = options.get_probe_quantities();
+
+  // Locked sites hold probes of type none, and are never mutable. A seed is only kept if it's forced.
+  for (const std::vector<Placement> *placements : {&options.get_locked_sites(), &options.get_seed()}) {
+    for (const Placement &placement : *placements) {
+      const size_t site_idx = FnSite::idx_for_id.at(placement.get_site().site_id);
+      const Probe &probe = placement.get_probe();
+      if (options.get_force_seed() || probe.probe_type == Probe::Type::none) {
+        maybe_fixed_probe_idxs[site_idx] = probe.probe_id;
+      } else {
+        ++mutable_probe_quantities[probe.probe_id];
+      }
+    }
+  }
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    if (!maybe_fixed_probe_idxs[site_idx]) {
+      mutable_site_idxs.push_back(site_idx);
+    }
+  }
+
+  resolve_precious_resource_bounds(options);
+  resolve_yield_bounds(options);
+  infeasible = !std::all_of(bounds.cbegin(), bounds.cend(), std::mem_fn(&Bound::can_be_met));
+  if (!infeasible) {
+    resolve_forced_collecting_site_idxs();
+  }
+}
+
+// static
+uint64_t Presolve::sum_largest(std::vector<uint64_t> &values, size_t count) {
+  count = std::min(count, values.size());
+  std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(count), values.end(),
+      std::greater<uint64_t>());
+  return std::accumulate(values.cbegin(), values.cbegin() + static_cast<std::ptrdiff_t>(count), uint64_t(0));
+}
+
+void Presolve::resolve_precious_resource_bounds(const Options &options) {
+  // Which sites collect only depends on whether their probe does, so the most is what the fixed sites collect, plus
+  // the richest mutable sites, one per collecting probe.
+  const size_t num_collecting_probes = get_num_collecting_probes();
+  for (size_t idx = 0; idx < precious_resource::count; ++idx) {
+    const uint32_t minimum = options.get_precious_resource_minimums()[idx];
+    if (minimum == 0) {
+      continue;
+    }
+
+    uint64_t fixed_quantity = 0;
+    for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+      if (maybe_fixed_probe_idxs[site_idx]
+          && LayoutEvaluator::collects_precious_resources(*maybe_fixed_probe_idxs[site_idx])) {
+        fixed_quantity += FnSite::sites[site_idx].precious_resource_quantities[idx];
+      }
+    }
+    std::vector<uint64_t> quantities;
+    for (const size_t site_idx : mutable_site_idxs) {
+      quantities.push_back(FnSite::sites[site_idx].precious_resource_quantities[idx]);
+    }
+
+    bounds.push_back({
+      .kind = Bound::Kind::precious_resource,
+      .precious_resource_type = static_cast<precious_resource::Type>(idx),
+      .minimum = minimum,
+      .max = fixed_quantity + sum_largest(quantities, num_collecting_probes),
+    });
+  }
+}
+
+void Presolve::resolve_yield_bounds(const Options &options) {
+  const std::array<std::pair<Bound::Kind, uint32_t>, 3> minimums = {{
+    {Bound::Kind::production, options.get_production_minimum()},
+    {Bound::Kind::revenue, options.get_revenue_minimum()},
+    {Bound::Kind::storage, options.get_storage_minimum()},
+  }};
+  for (size_t yield = 0; yield < minimums.size(); ++yield) {
+    const auto [kind, minimum] = minimums[yield];
+    if (minimum != 0) {
+      bounds.push_back({
+        .kind = kind,
+        .precious_resource_type = precious_resource::Type{},
+        .minimum = minimum,
+        .max = yield_bound(yield),
+      });
+    }
+  }
+}
+
+uint64_t Presolve::yield_bound(size_t yield) const {
+  const SiteTopology &topology = SiteTopology::get();
+  const YieldTable &yield_table = YieldTable::get();
+
+  const auto may_hold = [&](size_t site_idx, size_t probe_idx) {
+    return maybe_fixed_probe_idxs[site_idx]
+        ? *maybe_fixed_probe_idxs[site_idx] == probe_idx
+        : mutable_probe_quantities[probe_idx] > 0;
+  };
+
+  // A chain is no longer than the number of its probe that can be placed, which caps its bonus
+  std::array<double, Probe::num_probes> max_chain_factors;
+  std::vector<double> booster_factors;
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    size_t num_placed = std::min<size_t>(mutable_probe_quantities[probe_idx], mutable_site_idxs.size());
+    for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+      num_placed += maybe_fixed_probe_idxs[site_idx] == probe_idx ? 1 : 0;
+    }
+    const Probe &probe = Probe::probes[probe_idx];
+    max_chain_factors[probe_idx] = (100.0 + LayoutEvaluator::chain_bonus_for_length(probe, num_placed)) / 100.0;
+    if (probe.probe_type == Probe::Type::booster) {
+      booster_factors.insert(booster_factors.end(), num_placed, (100.0 + probe.boost_bonus) / 100.0);
+    }
+  }
+  // Product of the largest count booster factors, for a duplicator next to count boosters
+  std::sort(booster_factors.begin(), booster_factors.end(), std::greater<double>());
+  std::vector<double> max_booster_products = {1.0};
+  for (const double booster_factor : booster_factors) {
+    max_booster_products.push_back(max_booster_products.back() * booster_factor);
+  }
+
+  // The most each site could boost a neighbor by, whatever it holds, and so the most each site could be boosted by.
+  // A boosted site isn't a booster itself, so a duplicator next to it copies at most its other neighbors' boosts.
+  std::array<double, FnSite::num_sites> max_outgoing_boosts;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    double max_outgoing_boost = 1.0;
+    for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+      if (!may_hold(site_idx, probe_idx)) {
+        continue;
+      }
+      const Probe &probe = Probe::probes[probe_idx];
+      if (probe.probe_type == Probe::Type::booster) {
+        max_outgoing_boost = std::max(
+            max_outgoing_boost,
+            (100.0 + probe.boost_bonus) / 100.0 * max_chain_factors[probe_idx]);
+      } else if (probe.probe_type == Probe::Type::duplicator && !booster_factors.empty()) {
+        const size_t max_boosting_neighbors = std::min(topology.neighbors(site_idx).size() - 1, booster_factors.size());
+        max_outgoing_boost = std::max(
+            max_outgoing_boost,
+            max_booster_products[max_boosting_neighbors] * max_chain_factors[probe_idx]);
+      }
+    }
+    max_outgoing_boosts[site_idx] = max_outgoing_boost;
+  }
+  std::array<double, FnSite::num_sites> max_incoming_boosts;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    max_incoming_boosts[site_idx] = 1.0;
+    for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+      max_incoming_boosts[site_idx] *= max_outgoing_boosts[neighbor_idx];
+    }
+  }
+
+  // The most site_idx could yield from probe_idx's table entry, with the chain bonus of the probe it holds, and from
+  // holding probe_idx, which for a duplicator is whatever its neighbors may hold
+  const auto max_entry_yield = [&](size_t site_idx, size_t probe_idx, double max_chain_factor) {
+    const YieldTable::Entry &entry = yield_table.entry(site_idx, probe_idx);
+    double value = entry.unboosted[yield];
+    if (entry.boostable != 0 && entry.boosted_yield == yield) {
+      value += entry.boostable * max_chain_factor * max_incoming_boosts[site_idx];
+    }
+    return value;
+  };
+  const auto max_site_yield = [&](size_t site_idx, size_t probe_idx) {
+    if (Probe::probes[probe_idx].probe_type != Probe::Type::duplicator) {
+      return max_entry_yield(site_idx, probe_idx, max_chain_factors[probe_idx]);
+    }
+    double value = 0.0;
+    for (const size_t neighbor_idx : topology.neighbors(site_idx)) {
+      double max_copied = 0.0;
+      for (size_t neighbor_probe_idx = 0; neighbor_probe_idx < Probe::num_probes; ++neighbor_probe_idx) {
+        if (may_hold(neighbor_idx, neighbor_probe_idx)) {
+          max_copied = std::max(
+              max_copied,
+              max_entry_yield(site_idx, neighbor_probe_idx, max_chain_factors[probe_idx]));
+        }
+      }
+      value += max_copied;
+    }
+    return value;
+  };
+
+  // Both bounds are sound, and each is tighter where the other is loose: every site holding its best probe ignores
+  // how few of each probe there are, and every probe on its best sites ignores that a site holds only one.
+  double per_site_bound = 0.0;
+  double fixed_yield = 0.0;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    double max_yield = 0.0;
+    for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+      if (may_hold(site_idx, probe_idx)) {
+        max_yield = std::max(max_yield, max_site_yield(site_idx, probe_idx));
+      }
+    }
+    per_site_bound += max_yield;
+    if (maybe_fixed_probe_idxs[site_idx]) {
+      fixed_yield += max_yield;
+    }
+  }
+  double per_probe_bound = fixed_yield;
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    if (mutable_probe_quantities[probe_idx] == 0) {
+      continue;
+    }
+    // scaled to integers, sum_largest works on those
+    std::vector<uint64_t> yields;
+    for (const size_t site_idx : mutable_site_idxs) {
+      yields.push_back(static_cast<uint64_t>(std::ceil(max_site_yield(site_idx, probe_idx))));
+    }
+    per_probe_bound += static_cast<double>(sum_largest(yields, mutable_probe_quantities[probe_idx]));
+  }
+
+  // every site's revenue is halved
+  const double bound = std::min(per_site_bound, per_probe_bound) * (yield == YieldTable::revenue ? 0.5 : 1.0);
+  return static_cast<uint64_t>(std::floor(bound)) + (yield == YieldTable::storage ? base_storage : 0);
+}
+
+void Presolve::resolve_forced_collecting_site_idxs() {
+  // A site the minimum can't be met without is one whose quantity, swapped for the richest site left out, falls short
+  const size_t num_collecting_probes = get_num_collecting_probes();
+  std::vector<bool> site_idx_is_forced(FnSite::num_sites, false);
+  for (const Bound &bound : bounds) {
+    if (bound.kind != Bound::Kind::precious_resource) {
+      continue;
+    }
+
+    const size_t idx = static_cast<size_t>(bound.precious_resource_type);
+    std::vector<uint64_t> quantities;
+    for (const size_t site_idx : mutable_site_idxs) {
+      quantities.push_back(FnSite::sites[site_idx].precious_resource_quantities[idx]);
+    }
+    std::sort(quantities.begin(), quantities.end(), std::greater<uint64_t>());
+    const uint64_t richest_left_out = num_collecting_probes < quantities.size() ? quantities[num_collecting_probes] : 0;
+
+    // Sites that aren't among the richest hold no more than the richest left out, so they're never forced.
+    for (const size_t site_idx : mutable_site_idxs) {
+      const uint64_t quantity = FnSite::sites[site_idx].precious_resource_quantities[idx];
+      if (quantity > 0 && bound.max + richest_left_out - quantity < bound.minimum) {
+        site_idx_is_forced[site_idx] = true;
+      }
+    }
+  }
+
+  for (const size_t site_idx : mutable_site_idxs) {
+    if (site_idx_is_forced[site_idx]) {
+      forced_collecting_site_idxs.push_back(site_idx);
+    }
+  }
+
+  // Each minimum can be met on its own, but not all of them at once if they need more sites than there are probes
+  num_required_collecting_sites = forced_collecting_site_idxs.size();
+  if (num_required_collecting_sites > num_collecting_probes) {
+    infeasible = true;
+    forced_collecting_site_idxs.clear();
+  }
+}
+
+size_t Presolve::get_num_collecting_probes() const {
+  size_t num_collecting_probes = 0;
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    if (LayoutEvaluator::collects_precious_resources(probe_idx)) {
+      num_collecting_probes += mutable_probe_quantities[probe_idx];
+    }
+  }
+  return std::min(num_collecting_probes, mutable_site_idxs.size());
+}
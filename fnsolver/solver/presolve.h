@@ -0,0 +1,90 @@
+#ifndef FNSOLVER_SOLVER_PRESOLVE_H
+#define FNSOLVER_SOLVER_PRESOLVE_H
+
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/solver/options.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * What follows from a run's options alone, before solving: the most each constraint could possibly reach given the
+ * inventory, locked sites, and seed, and which sites every layout meeting the precious resource minimums must hold a
+ * collecting probe on. Reflects the territories as currently overridden.
+ */
+class Presolve {
+  public:
+    /** A constraint that is set, and the most any layout could yield of it */
+    struct Bound {
+      enum class Kind {
+        precious_resource,
+        production,
+        revenue,
+        storage
+      };
+
+      Kind kind;
+      /** Only for Kind::precious_resource */
+      precious_resource::Type precious_resource_type;
+      uint32_t minimum;
+      /** Exact for precious resources, an upper bound for yields, which depend on chains and boosts */
+      uint64_t max;
+
+      bool can_be_met() const { return max >= minimum; }
+    };
+
+    explicit Presolve(const Options &options);
+
+    Presolve(const Presolve &other) = default;
+    Presolve(Presolve &&other) = default;
+    Presolve &operator=(const Presolve &other) = default;
+    Presolve &operator=(Presolve &&other) = default;
+
+    /** Sites whose probe may change while solving, a locked site or one with a forced seed keeps its probe */
+    const std::vector<size_t> &get_mutable_site_idxs() const { return mutable_site_idxs; }
+    /** Precious resources first, then production, revenue, and storage, each only if its minimum is set */
+    const std::vector<Bound> &get_bounds() const { return bounds; }
+    /**
+     * Whether no layout can meet the constraints, because some bound can't be met, or the precious resource minimums
+     * together need more collecting sites than there are collecting probes. Nothing is forced if so.
+     */
+    bool is_infeasible() const { return infeasible; }
+    /**
+     * Mutable sites that every layout meeting the precious resource minimums holds a collecting probe on, because
+     * the minimums can't be met without what they collect. Ordered, and never more than get_num_collecting_probes().
+     */
+    const std::vector<size_t> &get_forced_collecting_site_idxs() const { return forced_collecting_site_idxs; }
+    /**
+     * How many mutable sites the precious resource minimums together need a collecting probe on, even when that's
+     * more than get_num_collecting_probes(). 0 if some bound can't be met.
+     */
+    size_t get_num_required_collecting_sites() const { return num_required_collecting_sites; }
+    /** Collecting probes the mutable sites can hold at once */
+    size_t get_num_collecting_probes() const;
+  private:
+    /** Probe index of each site that isn't mutable */
+    std::array<std::optional<size_t>, FnSite::num_sites> maybe_fixed_probe_idxs;
+    std::vector<size_t> mutable_site_idxs;
+    /** Probes the mutable sites are filled from: the inventory, and the seed on mutable sites */
+    std::array<uint32_t, Probe::num_probes> mutable_probe_quantities;
+    std::vector<Bound> bounds;
+    bool infeasible;
+    std::vector<size_t> forced_collecting_site_idxs;
+    size_t num_required_collecting_sites;
+
+    /** Sum of the largest count values, which are left partially sorted */
+    static uint64_t sum_largest(std::vector<uint64_t> &values, size_t count);
+
+    void resolve_precious_resource_bounds(const Options &options);
+    void resolve_yield_bounds(const Options &options);
+    /** Upper bound on the yield (YieldTable::BoostedYield) of any layout */
+    uint64_t yield_bound(size_t yield) const;
+    /** Only sound once every bound can be met */
+    void resolve_forced_collecting_site_idxs();
+};
+
+#endif // FNSOLVER_SOLVER_PRESOLVE_H
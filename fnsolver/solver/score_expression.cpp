@@ -0,0 +1,538 @@
+#include <fnsolver/solver/score_expression.h>
+
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
+#include <fnsolver/util/simd.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr double infinity = std::numeric_limits<double>::infinity();
+
+/** Spelled as a comparison rather than std::isnan(), so that the loops over lanes still vectorize */
+double zero_if_nan(double value) {
+  return value == value ? value : 0.0;
+}
+
+/** How a subexpression changes as mining, revenue, or storage increase */
+enum class Direction {
+  none,
+  increasing,
+  decreasing,
+  unknown
+};
+
+Direction negate(Direction direction) {
+  switch (direction) {
+  case Direction::increasing:
+    return Direction::decreasing;
+  case Direction::decreasing:
+    return Direction::increasing;
+  default:
+    return direction;
+  }
+}
+
+/** Direction of a sum, or a min or max, of subexpressions going in lhs and rhs directions */
+Direction combine(Direction lhs, Direction rhs) {
+  if (lhs == Direction::none) {
+    return rhs;
+  }
+  if (rhs == Direction::none || lhs == rhs) {
+    return lhs;
+  }
+  return Direction::unknown;
+}
+
+/** Direction of factor times a subexpression going in direction, where factor only takes values in [min, max] */
+Direction scale(Direction direction, double min, double max) {
+  if (min >= 0) {
+    return direction;
+  }
+  if (max <= 0) {
+    return negate(direction);
+  }
+  return direction == Direction::none ? Direction::none : Direction::unknown;
+}
+} // namespace
+
+// static
+double ScoreExpression::apply(Op op, double lhs, double rhs) {
+  switch (op) {
+  case Op::add:
+    return zero_if_nan(lhs + rhs);
+  case Op::subtract:
+    return zero_if_nan(lhs - rhs);
+  case Op::multiply:
+    return zero_if_nan(lhs * rhs);
+  case Op::divide:
+    return rhs == 0 ? 0.0 : zero_if_nan(lhs / rhs);
+  case Op::min:
+    return std::min(lhs, rhs);
+  case Op::max:
+    return std::max(lhs, rhs);
+  case Op::negate:
+    return -lhs;
+  }
+  return 0.0;
+}
+
+/** Parses into a tree, folding constants and bounding every node, then allocates registers for what is left */
+class ScoreExpression::Compiler {
+  public:
+    explicit Compiler(ScoreExpression &expression) : expression(expression), text(expression.text) {}
+
+    void compile() {
+      const size_t root_idx = parse_expression();
+      skip_whitespace();
+      if (pos != text.size()) {
+        fail("Expected an operator");
+      }
+
+      // negative scores count as 0, which keeps a monotone score monotone
+      size_t result_idx = root_idx;
+      if (nodes[root_idx].min < 0) {
+        result_idx = create_operation(Op::max, create_constant(0.0), root_idx);
+      }
+      expression.monotone = nodes[result_idx].direction == Direction::none
+          || nodes[result_idx].direction == Direction::increasing;
+
+      // constants come first, so that temporaries are all that is left to allocate
+      collect_constants(result_idx);
+      next_temporary_register = num_inputs + expression.constants.size();
+      if (next_temporary_register > max_registers) {
+        fail_too_many_registers();
+      }
+      expression.result_register = generate(result_idx);
+    }
+  private:
+    enum class Kind {
+      constant,
+      input,
+      operation
+    };
+
+    struct Node {
+      Kind kind;
+      /** Inputs only */
+      uint8_t input_register;
+      /** Operations only, negate only uses lhs_idx */
+      Op op;
+      size_t lhs_idx;
+      size_t rhs_idx;
+      /** Bounds on what the node evaluates to, both are the value of a constant */
+      double min;
+      double max;
+      Direction direction;
+    };
+
+    ScoreExpression &expression;
+    std::string_view text;
+    size_t pos = 0;
+    std::vector<Node> nodes;
+
+    size_t next_temporary_register = 0;
+    std::vector<uint8_t> free_temporary_registers;
+
+    [[noreturn]] void fail(const std::string &message) const {
+      throw std::invalid_argument(std::format("{} at position {} of \"{}\"", message, pos + 1, text));
+    }
+
+    [[noreturn]] void fail_too_many_registers() const {
+      throw std::invalid_argument(std::format(
+          "\"{}\" has too many constants/subexpressions, the variables, constants, and intermediate results need more "
+          "than {} registers",
+          text,
+          max_registers));
+    }
+
+    void skip_whitespace() {
+      while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+        ++pos;
+      }
+    }
+
+    bool consume(char c) {
+      skip_whitespace();
+      if (pos < text.size() && text[pos] == c) {
+        ++pos;
+        return true;
+      }
+      return false;
+    }
+
+    size_t create_constant(double value) {
+      nodes.push_back(Node{
+        .kind = Kind::constant, .input_register = 0, .op = Op::add, .lhs_idx = 0, .rhs_idx = 0,
+        .min = value, .max = value, .direction = Direction::none
+      });
+      return nodes.size() - 1;
+    }
+
+    size_t create_input(size_t input_register) {
+      // precious resource quantities are exact even in a bound on a layout's yield, so only yields need be monotone
+      nodes.push_back(Node{
+        .kind = Kind::input, .input_register = static_cast<uint8_t>(input_register), .op = Op::add, .lhs_idx = 0,
+        .rhs_idx = 0, .min = 0.0, .max = infinity,
+        .direction = input_register < 3 ? Direction::increasing : Direction::none
+      });
+      return nodes.size() - 1;
+    }
+
+    size_t create_operation(Op op, size_t lhs_idx, size_t rhs_idx) {
+      const Node lhs = nodes[lhs_idx];
+      const Node rhs = nodes[rhs_idx];
+      if (lhs.kind == Kind::constant && rhs.kind == Kind::constant) {
+        return create_constant(apply(op, lhs.min, rhs.min));
+      }
+
+      Node node{
+        .kind = Kind::operation, .input_register = 0, .op = op, .lhs_idx = lhs_idx, .rhs_idx = rhs_idx,
+        .min = -infinity, .max = infinity, .direction = Direction::unknown
+      };
+      switch (op) {
+      case Op::add:
+        node.min = or_if_nan(lhs.min + rhs.min, -infinity);
+        node.max = or_if_nan(lhs.max + rhs.max, infinity);
+        node.direction = combine(lhs.direction, rhs.direction);
+        break;
+      case Op::subtract:
+        node.min = or_if_nan(lhs.min - rhs.max, -infinity);
+        node.max = or_if_nan(lhs.max - rhs.min, infinity);
+        node.direction = combine(lhs.direction, negate(rhs.direction));
+        break;
+      case Op::multiply:
+        bound_product(node, lhs, rhs.min, rhs.max, rhs.direction);
+        break;
+      case Op::divide:
+        // as lhs times 1 / rhs, which is only bounded if rhs can't be 0
+        if (rhs.min > 0 || rhs.max < 0) {
+          bound_product(node, lhs, 1.0 / rhs.max, 1.0 / rhs.min, negate(rhs.direction));
+        } else if (lhs.direction == Direction::none && rhs.direction == Direction::none) {
+          node.direction = Direction::none;
+        }
+        break;
+      case Op::min:
+      case Op::max:
+        node.min = apply(op, lhs.min, rhs.min);
+        node.max = apply(op, lhs.max, rhs.max);
+        node.direction = combine(lhs.direction, rhs.direction);
+        break;
+      case Op::negate:
+        node.min = -lhs.max;
+        node.max = -lhs.min;
+        node.direction = negate(lhs.direction);
+        break;
+      }
+      nodes.push_back(node);
+      return nodes.size() - 1;
+    }
+
+    static double or_if_nan(double value, double fallback) { return std::isnan(value) ? fallback : value; }
+
+    /** Bounds node as lhs times a factor in [rhs_min, rhs_max] going in rhs_direction */
+    static void bound_product(Node &node, const Node &lhs, double rhs_min, double rhs_max, Direction rhs_direction) {
+      // 0 times an unbounded end is still 0
+      const std::array<double, 4> products = {
+        or_if_nan(lhs.min * rhs_min, 0.0),
+        or_if_nan(lhs.min * rhs_max, 0.0),
+        or_if_nan(lhs.max * rhs_min, 0.0),
+        or_if_nan(lhs.max * rhs_max, 0.0)
+      };
+      node.min = *std::min_element(products.cbegin(), products.cend());
+      node.max = *std::max_element(products.cbegin(), products.cend());
+
+      if (lhs.direction == Direction::none) {
+        node.direction = scale(rhs_direction, lhs.min, lhs.max);
+      } else if (rhs_direction == Direction::none) {
+        node.direction = scale(lhs.direction, rhs_min, rhs_max);
+      } else if (lhs.min >= 0 && rhs_min >= 0 && lhs.direction == rhs_direction) {
+        node.direction = lhs.direction;
+      }
+    }
+
+    // expression := term (("+" | "-") term)*
+    size_t parse_expression() {
+      size_t lhs_idx = parse_term();
+      while (true) {
+        if (consume('+')) {
+          lhs_idx = create_operation(Op::add, lhs_idx, parse_term());
+        } else if (consume('-')) {
+          lhs_idx = create_operation(Op::subtract, lhs_idx, parse_term());
+        } else {
+          return lhs_idx;
+        }
+      }
+    }
+
+    // term := unary (("*" | "/") unary)*
+    size_t parse_term() {
+      size_t lhs_idx = parse_unary();
+      while (true) {
+        if (consume('*')) {
+          lhs_idx = create_operation(Op::multiply, lhs_idx, parse_unary());
+        } else if (consume('/')) {
+          lhs_idx = create_operation(Op::divide, lhs_idx, parse_unary());
+        } else {
+          return lhs_idx;
+        }
+      }
+    }
+
+    // unary := "-" unary | primary
+    size_t parse_unary() {
+      if (consume('-')) {
+        const size_t operand_idx = parse_unary();
+        return create_operation(Op::negate, operand_idx, operand_idx);
+      }
+      return parse_primary();
+    }
+
+    // primary := number | variable | "(" expression ")" | ("min" | "max") "(" expression ("," expression)* ")"
+    size_t parse_primary() {
+      if (consume('(')) {
+        const size_t idx = parse_expression();
+        if (!consume(')')) {
+          fail("Expected \")\"");
+        }
+        return idx;
+      }
+
+      if (pos < text.size() && (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '.')) {
+        double value;
+        const auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+        if (error != std::errc()) {
+          fail("Invalid number");
+        }
+        pos = end - text.data();
+        return create_constant(value);
+      }
+
+      const size_t name_pos = pos;
+      while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '_')) {
+        ++pos;
+      }
+      const std::string name(text.substr(name_pos, pos - name_pos));
+      if (name.empty()) {
+        fail("Expected a number, variable, or \"(\"");
+      }
+
+      if (name == "min" || name == "max") {
+        const Op op = name == "min" ? Op::min : Op::max;
+        if (!consume('(')) {
+          fail(std::format("Expected \"(\" after \"{}\"", name));
+        }
+        size_t idx = parse_expression();
+        while (consume(',')) {
+          idx = create_operation(op, idx, parse_expression());
+        }
+        if (!consume(')')) {
+          fail("Expected \",\" or \")\"");
+        }
+        return idx;
+      }
+
+      if (name == "mining") {
+        return create_input(0);
+      }
+      if (name == "revenue") {
+        return create_input(1);
+      }
+      if (name == "storage") {
+        return create_input(2);
+      }
+      if (precious_resource::type_for_str.contains(name)) {
+        return create_input(3 + static_cast<size_t>(precious_resource::type_for_str.at(name)));
+      }
+      pos = name_pos;
+      fail(std::format("Unknown variable \"{}\"", name));
+    }
+
+    size_t find_constant(double value) const {
+      // bitwise, so that 0 and -0 stay apart
+      const auto constant_it = std::find_if(
+          expression.constants.cbegin(), expression.constants.cend(),
+          [&](double constant) { return std::bit_cast<uint64_t>(constant) == std::bit_cast<uint64_t>(value); });
+      return constant_it - expression.constants.cbegin();
+    }
+
+    void collect_constants(size_t idx) {
+      const Node &node = nodes[idx];
+      switch (node.kind) {
+      case Kind::constant:
+        if (find_constant(node.min) == expression.constants.size()) {
+          expression.constants.push_back(node.min);
+        }
+        break;
+      case Kind::input:
+        break;
+      case Kind::operation:
+        collect_constants(node.lhs_idx);
+        collect_constants(node.rhs_idx);
+        break;
+      }
+    }
+
+    /** Emits instructions computing the node, returns the register holding it */
+    uint8_t generate(size_t idx) {
+      const Node &node = nodes[idx];
+      switch (node.kind) {
+      case Kind::constant:
+        return static_cast<uint8_t>(num_inputs + find_constant(node.min));
+      case Kind::input:
+        if (std::find(expression.input_registers.cbegin(), expression.input_registers.cend(), node.input_register)
+            == expression.input_registers.cend()) {
+          expression.input_registers.push_back(node.input_register);
+        }
+        return node.input_register;
+      case Kind::operation:
+        break;
+      }
+
+      const uint8_t lhs_register = generate(node.lhs_idx);
+      const uint8_t rhs_register = node.op == Op::negate ? lhs_register : generate(node.rhs_idx);
+      // operands are read before the result is written, so the result may reuse either's register
+      free_register(lhs_register);
+      if (rhs_register != lhs_register) {
+        free_register(rhs_register);
+      }
+      const uint8_t result_register = allocate_temporary_register();
+      expression.instructions.push_back(
+          {.op = node.op, .result = result_register, .lhs = lhs_register, .rhs = rhs_register});
+      return result_register;
+    }
+
+    uint8_t allocate_temporary_register() {
+      if (!free_temporary_registers.empty()) {
+        const uint8_t temporary_register = free_temporary_registers.back();
+        free_temporary_registers.pop_back();
+        return temporary_register;
+      }
+      if (next_temporary_register >= max_registers) {
+        fail_too_many_registers();
+      }
+      return static_cast<uint8_t>(next_temporary_register++);
+    }
+
+    void free_register(uint8_t reg) {
+      if (reg >= num_inputs + expression.constants.size()) {
+        free_temporary_registers.push_back(reg);
+      }
+    }
+};
+
+ScoreExpression::ScoreExpression(std::string text) : text(std::move(text)), result_register(0), monotone(false) {
+  Compiler(*this).compile();
+}
+
+double ScoreExpression::operator()(const ResourceYield &resource_yield) const {
+  const std::array<uint32_t, 3> yields = {
+    resource_yield.get_production(),
+    resource_yield.get_revenue(),
+    resource_yield.get_storage()
+  };
+  columns_t columns;
+  for (size_t input_idx = 0; input_idx < num_inputs; ++input_idx) {
+    columns[input_idx] = input_idx < yields.size()
+        ? &yields[input_idx]
+        : &resource_yield.get_precious_resource_quantities()[input_idx - yields.size()];
+  }
+
+  double score;
+  run(columns, 1, &score);
+  return score;
+}
+
+void ScoreExpression::operator()(const ResourceYieldBatch &batch, std::span<double> scores) const {
+  columns_t columns = {batch.get_productions().data(), batch.get_revenues().data(), batch.get_storages().data()};
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    columns[3 + precious_resource_idx] = batch.get_precious_resource_quantities(precious_resource_idx).data();
+  }
+  run(columns, scores.size(), scores.data());
+}
+
+void ScoreExpression::run(const columns_t &columns, size_t num_lanes, double *scores) const {
+  registers_t registers;
+  for (size_t constant_idx = 0; constant_idx < constants.size(); ++constant_idx) {
+    registers[num_inputs + constant_idx].fill(constants[constant_idx]);
+  }
+
+  for (size_t block_begin = 0; block_begin < num_lanes; block_begin += block_size) {
+    // the lanes past the end of a short last block run on zeros, and are never read back
+    const size_t num_block_lanes = std::min(block_size, num_lanes - block_begin);
+    for (const uint8_t input_register : input_registers) {
+      const uint32_t *column = columns[input_register] + block_begin;
+      block_t &input = registers[input_register];
+      if (num_block_lanes == block_size) {
+        std::copy_n(column, block_size, input.begin());
+      } else {
+        std::fill(std::copy_n(column, num_block_lanes, input.begin()), input.end(), 0.0);
+      }
+    }
+    run_block(registers);
+    std::copy_n(registers[result_register].cbegin(), num_block_lanes, scores + block_begin);
+  }
+}
+
+FNSOLVER_SIMD_CLONES
+void ScoreExpression::run_block(registers_t &registers) const {
+  for (const Instruction &instruction : instructions) {
+    block_t &result = registers[instruction.result];
+    const block_t &lhs = registers[instruction.lhs];
+    const block_t &rhs = registers[instruction.rhs];
+    // one loop per op, rather than dispatching per lane
+    switch (instruction.op) {
+    case Op::add:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = zero_if_nan(lhs[lane] + rhs[lane]);
+      }
+      break;
+    case Op::subtract:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = zero_if_nan(lhs[lane] - rhs[lane]);
+      }
+      break;
+    case Op::multiply:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = zero_if_nan(lhs[lane] * rhs[lane]);
+      }
+      break;
+    case Op::divide:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = rhs[lane] == 0 ? 0.0 : zero_if_nan(lhs[lane] / rhs[lane]);
+      }
+      break;
+    case Op::min:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = std::min(lhs[lane], rhs[lane]);
+      }
+      break;
+    case Op::max:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = std::max(lhs[lane], rhs[lane]);
+      }
+      break;
+    case Op::negate:
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        result[lane] = -lhs[lane];
+      }
+      break;
+    }
+  }
+}
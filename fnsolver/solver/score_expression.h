@@ -0,0 +1,90 @@
+#ifndef FNSOLVER_SOLVER_SCORE_EXPRESSION_H
+#define FNSOLVER_SOLVER_SCORE_EXPRESSION_H
+
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * User-defined score, such as "min(mining * 1.2, storage) + 0.1 * revenue + 50 * bonjelium".
+ *
+ * Supports numbers, the variables mining, revenue, storage, and each precious resource by name, the operators + - * /,
+ * parentheses, and min(...) and max(...) of one or more arguments. The text is parsed once, constant subexpressions
+ * are folded, and what is left is compiled to instructions over a fixed set of registers, so scoring never allocates.
+ * Scores below 0 count as 0, like a layout missing a constraint does. Dividing by 0, or any other operation whose
+ * result isn't a number, gives 0.
+ */
+class ScoreExpression {
+  public:
+    static constexpr size_t max_registers = 64;
+
+    /** Throws std::invalid_argument if text does not parse */
+    explicit ScoreExpression(std::string text);
+
+    ScoreExpression(const ScoreExpression &other) = default;
+    ScoreExpression(ScoreExpression &&other) = default;
+    ScoreExpression &operator=(const ScoreExpression &other) = default;
+    ScoreExpression &operator=(ScoreExpression &&other) = default;
+
+    const std::string &get_text() const { return text; }
+    /** Whether the score never decreases as mining, revenue, or storage increase */
+    bool is_monotone() const { return monotone; }
+    double operator()(const ResourceYield &resource_yield) const;
+    /** scores must have batch.size() elements */
+    void operator()(const ResourceYieldBatch &batch, std::span<double> scores) const;
+  private:
+    class Compiler;
+
+    /** Registers [0, num_inputs) hold the variables, followed by the constants, followed by temporaries */
+    static constexpr size_t num_inputs = 3 + precious_resource::count;
+    /**
+     * Each instruction runs over this many lanes at once, so that decoding it is paid once per block, and the loop
+     * over the lanes vectorizes.
+     */
+    static constexpr size_t block_size = 16;
+
+    using block_t = std::array<double, block_size>;
+    using registers_t = std::array<block_t, max_registers>;
+    /** One lane per layout, indexed like the input registers */
+    using columns_t = std::array<const uint32_t *, num_inputs>;
+
+    enum class Op : uint8_t {
+      add,
+      subtract,
+      multiply,
+      divide,
+      min,
+      max,
+      negate
+    };
+
+    struct Instruction {
+      Op op;
+      uint8_t result;
+      uint8_t lhs;
+      /** Unused by negate */
+      uint8_t rhs;
+    };
+
+    std::string text;
+    /** Inputs the instructions read, so scoring only loads those */
+    std::vector<uint8_t> input_registers;
+    std::vector<double> constants;
+    std::vector<Instruction> instructions;
+    uint8_t result_register;
+    bool monotone;
+
+    /** What an instruction computes for each lane, for folding constants the same way */
+    static double apply(Op op, double lhs, double rhs);
+
+    void run(const columns_t &columns, size_t num_lanes, double *scores) const;
+    void run_block(registers_t &registers) const;
+};
+
+#endif // FNSOLVER_SOLVER_SCORE_EXPRESSION_H
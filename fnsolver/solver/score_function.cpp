@@ -1,7 +1,10 @@
 #include <fnsolver/solver/score_function.h>
 
 #include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
 #include <fnsolver/layout/layout.h>
+#include <fnsolver/solver/score_expression.h>
+#include <fnsolver/util/simd.hpp>
 
 #include <algorithm>
 #include <array>
@@ -9,9 +12,124 @@
 #include <cstdint>
 #include <format>
 #include <limits>
+#include <span>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <variant>
+
+namespace {
+/** Columns of a batch that the constraints are checked against, indexed by lane */
+struct ConstrainedColumns {
+  std::span<const uint32_t> productions;
+  std::span<const uint32_t> revenues;
+  std::span<const uint32_t> storages;
+  std::array<std::span<const uint32_t>, precious_resource::count> precious_resource_quantities;
+
+  explicit ConstrainedColumns(const ResourceYieldBatch &batch)
+      : productions(batch.get_productions()), revenues(batch.get_revenues()), storages(batch.get_storages()) {
+    for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+      precious_resource_quantities[precious_resource_idx]
+          = batch.get_precious_resource_quantities(precious_resource_idx);
+    }
+  }
+};
+
+bool meets_minimums(const ConstrainedColumns &columns, const ScoreFunction::Constraints &constraints, size_t i) {
+  bool meets_minimums = columns.productions[i] >= constraints.production_minimum
+      && columns.revenues[i] >= constraints.revenue_minimum
+      && columns.storages[i] >= constraints.storage_minimum;
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    meets_minimums = meets_minimums
+        && columns.precious_resource_quantities[precious_resource_idx][i]
+          >= constraints.precious_resource_minimums[precious_resource_idx];
+  }
+  return meets_minimums;
+}
+
+/** How far value falls short of minimum, as a fraction of minimum */
+double relative_shortfall(uint32_t value, uint32_t minimum) {
+  return value < minimum ? static_cast<double>(minimum - value) / minimum : 0.0;
+}
+
+/** Sum of the lane's relative shortfalls on every minimum, 0 if and only if it meets them all */
+double shortfall(const ConstrainedColumns &columns, const ScoreFunction::Constraints &constraints, size_t i) {
+  double shortfall = relative_shortfall(columns.productions[i], constraints.production_minimum)
+      + relative_shortfall(columns.revenues[i], constraints.revenue_minimum)
+      + relative_shortfall(columns.storages[i], constraints.storage_minimum);
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    shortfall += relative_shortfall(
+        columns.precious_resource_quantities[precious_resource_idx][i],
+        constraints.precious_resource_minimums[precious_resource_idx]);
+  }
+  return shortfall;
+}
+
+// The same kernel scores every lane exactly as it scores a single layout.
+
+template <typename Kernel>
+FNSOLVER_SIMD_CLONES
+void score_lanes(const Kernel &kernel, const ResourceYieldBatch &batch, std::span<double> scores) {
+  const std::span<const uint32_t> productions = batch.get_productions();
+  const std::span<const uint32_t> revenues = batch.get_revenues();
+  const std::span<const uint32_t> storages = batch.get_storages();
+  for (size_t i = 0; i < scores.size(); ++i) {
+    scores[i] = kernel(productions[i], revenues[i], storages[i]);
+  }
+}
+
+template <typename Kernel>
+FNSOLVER_SIMD_CLONES
+void score_lanes(
+    const Kernel &kernel,
+    const ResourceYieldBatch &batch,
+    const ScoreFunction::Constraints &constraints,
+    std::span<double> scores) {
+  const ConstrainedColumns columns(batch);
+  if (constraints.mode == ScoreFunction::ConstraintMode::penalty) {
+    for (size_t i = 0; i < scores.size(); ++i) {
+      const double lane_shortfall = shortfall(columns, constraints, i);
+      scores[i] = lane_shortfall > 0
+          ? -lane_shortfall
+          : kernel(columns.productions[i], columns.revenues[i], columns.storages[i]);
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < scores.size(); ++i) {
+    scores[i] = meets_minimums(columns, constraints, i)
+        ? kernel(columns.productions[i], columns.revenues[i], columns.storages[i])
+        : 0.0;
+  }
+}
+
+/** Expressions also read precious resource quantities, so they score every lane before checking the constraints */
+void score_expression_lanes(
+    const ScoreExpression &expression,
+    const ResourceYieldBatch &batch,
+    const ScoreFunction::Constraints &constraints,
+    std::span<double> scores) {
+  expression(batch, scores);
+
+  const ConstrainedColumns columns(batch);
+  if (constraints.mode == ScoreFunction::ConstraintMode::penalty) {
+    for (size_t i = 0; i < scores.size(); ++i) {
+      const double lane_shortfall = shortfall(columns, constraints, i);
+      if (lane_shortfall > 0) {
+        scores[i] = -lane_shortfall;
+      }
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < scores.size(); ++i) {
+    if (!meets_minimums(columns, constraints, i)) {
+      scores[i] = 0.0;
+    }
+  }
+}
+} // namespace
 
 // static
 const std::unordered_map<std::string, ScoreFunction::Type> ScoreFunction::type_for_str = {
@@ -20,101 +138,88 @@ const std::unordered_map<std::string, ScoreFunction::Type> ScoreFunction::type_f
   {"max_revenue", Type::max_revenue},
   {"max_storage", Type::max_storage},
   {"ratio", Type::ratio},
-  {"weights", Type::weights}
+  {"weights", Type::weights},
+  {"expr", Type::expression}
+};
+
+// static
+const std::string ScoreFunction::expression_prefix = "expr:";
+
+// static
+const std::unordered_map<std::string, ScoreFunction::ConstraintMode> ScoreFunction::constraint_mode_for_str = {
+  {"zero", ConstraintMode::zero},
+  {"penalty", ConstraintMode::penalty}
+};
+
+// static
+const std::unordered_map<ScoreFunction::ConstraintMode, std::string> ScoreFunction::str_for_constraint_mode = {
+  {ConstraintMode::zero, "zero"},
+  {ConstraintMode::penalty, "penalty"}
 };
 
+bool ScoreFunction::Constraints::are_met_by(const ResourceYield &resource_yield) const {
+  bool are_met = resource_yield.get_production() >= production_minimum
+      && resource_yield.get_revenue() >= revenue_minimum
+      && resource_yield.get_storage() >= storage_minimum;
+  for (size_t precious_resource_idx = 0; precious_resource_idx < precious_resource::count; ++precious_resource_idx) {
+    are_met = are_met
+        && resource_yield.get_precious_resource_quantities()[precious_resource_idx]
+          >= precious_resource_minimums[precious_resource_idx];
+  }
+  return are_met;
+}
+
 // static
 ScoreFunction ScoreFunction::create_max_mining() {
-  return ScoreFunction(
-      [](const Layout &layout) { return layout.get_resource_yield().get_production(); },
-      "max_mining");
+  return ScoreFunction(MaxMining{}, "max_mining");
 }
 
 // static
 ScoreFunction ScoreFunction::create_max_effective_mining(double storage_factor) {
   return ScoreFunction(
-      [=](const Layout &layout) {
-        const ResourceYield &resource_yield = layout.get_resource_yield();
-        return std::min(
-            storage_factor * resource_yield.get_production(),
-            static_cast<double>(resource_yield.get_storage()));
-      },
+      MaxEffectiveMining{.storage_factor = storage_factor},
       "max_effective_mining", {{"storage_factor", storage_factor}});
 }
 
 // static
 ScoreFunction ScoreFunction::create_max_revenue() {
-  return ScoreFunction(
-      [](const Layout &layout) { return layout.get_resource_yield().get_revenue(); },
-      "max_revenue");
+  return ScoreFunction(MaxRevenue{}, "max_revenue");
 }
 
 // static
 ScoreFunction ScoreFunction::create_max_storage() {
-  return ScoreFunction(
-      [](const Layout &layout) { return layout.get_resource_yield().get_storage(); },
-      "max_storage");
+  return ScoreFunction(MaxStorage{}, "max_storage");
 }
 
 // static
 ScoreFunction ScoreFunction::create_ratio(double mining_factor, double revenue_factor, double storage_factor) {
+  const std::array<double, 3> factors = {mining_factor, revenue_factor, storage_factor};
+  const double max_factor = *std::max_element(factors.cbegin(), factors.cend());
   return ScoreFunction(
-      [=](const Layout &layout) {
-        if (mining_factor <= 0 && revenue_factor <= 0 && storage_factor <= 0) {
-          return 0.0;
-        }
-
-        const ResourceYield &resource_yield = layout.get_resource_yield();
-        const std::array<double, 3> factors = {mining_factor, revenue_factor, storage_factor};
-        const std::array<uint32_t, 3> values = {
-          resource_yield.get_production(),
-          resource_yield.get_revenue(),
-          resource_yield.get_storage()
-        };
-
-        double min = std::numeric_limits<double>::max();
-        for (size_t i = 0; i < factors.size(); ++i) {
-          const double factor = factors[i];
-          if (factor <= 0) {
-            continue;
-          }
-
-          const double value = values[i] / factor;
-          if (value < min) {
-            min = value;
-          }
-        }
-
-        return min * (*std::max_element(factors.cbegin(), factors.cend()));
-      },
+      max_factor <= 0 ? kernel_t(Zero{}) : kernel_t(Ratio{.factors = factors, .max_factor = max_factor}),
       "ratio", {{"mining", mining_factor},{"revenue", revenue_factor}, {"storage", storage_factor}});
 }
 
 // static
 ScoreFunction ScoreFunction::create_weights(double mining_weight, double revenue_weight, double storage_weight) {
   return ScoreFunction(
-      [=](const Layout &layout) {
-        const ResourceYield &resource_yield = layout.get_resource_yield();
-        return mining_weight * resource_yield.get_production()
-            + revenue_weight * resource_yield.get_revenue()
-            + storage_weight * resource_yield.get_storage();
-      },
+      Weights{.weights = {mining_weight, revenue_weight, storage_weight}},
       "weights", {{"mining", mining_weight},{"revenue", revenue_weight}, {"storage", storage_weight}});
 }
 
-ScoreFunction::ScoreFunction(func_t score_function, std::string name, args_t args)
-    : score_function(std::move(score_function)),
-      name(std::move(name)), args(std::move(args)) {}
-
-ScoreFunction::ScoreFunction(const ScoreFunction& other) {
-  *this = other;
+// static
+ScoreFunction ScoreFunction::create_expression(const std::string &expression_text) {
+  return ScoreFunction(Expression{.expression = ScoreExpression(expression_text)}, "expr", {}, expression_text);
 }
 
-ScoreFunction& ScoreFunction::operator=(const ScoreFunction& other) {
-  return *this = from_name_and_args(other.name, other.get_args_map());
-}
+ScoreFunction::ScoreFunction(kernel_t kernel, std::string name, args_t args, std::string expression_text)
+    : kernel(std::move(kernel)),
+      name(std::move(name)), args(std::move(args)), expression_text(std::move(expression_text)) {}
 
 ScoreFunction ScoreFunction::from_name_and_args(const std::string& name, const args_map_t& args) {
+  if (name.starts_with(expression_prefix)) {
+    return create_expression(name.substr(expression_prefix.size()));
+  }
   switch (type_for_str.at(name)) {
     case Type::max_mining:
       return create_max_mining();
@@ -128,11 +233,16 @@ ScoreFunction ScoreFunction::from_name_and_args(const std::string& name, const a
       return create_ratio(args.at("mining"), args.at("revenue"), args.at("storage"));
     case Type::weights:
       return create_weights(args.at("mining"), args.at("revenue"), args.at("storage"));
+    case Type::expression:
+      throw std::logic_error("Expression score functions are named by their text");
   }
   throw std::logic_error("Unknown score function type");
 }
 
 ScoreFunction ScoreFunction::from_name_and_args(const std::string& name, const std::vector<double>& args) {
+  if (name.starts_with(expression_prefix)) {
+    return create_expression(name.substr(expression_prefix.size()));
+  }
   switch (type_for_str.at(name)) {
     case Type::max_mining:
       return create_max_mining();
@@ -146,6 +256,8 @@ ScoreFunction ScoreFunction::from_name_and_args(const std::string& name, const s
       return create_ratio(args.at(0), args.at(1), args.at(2));
     case Type::weights:
       return create_weights(args.at(0), args.at(1), args.at(2));
+    case Type::expression:
+      throw std::logic_error("Expression score functions are named by their text");
   }
   throw std::logic_error("Unknown score function type");
 }
@@ -155,6 +267,9 @@ ScoreFunction::args_map_t ScoreFunction::get_args_map() const {
 }
 
 std::string ScoreFunction::get_details_str() const {
+  if (!expression_text.empty()) {
+    return expression_prefix + expression_text;
+  }
   if (args.empty()) {
     return std::format("{}()", name);
   }
@@ -171,7 +286,50 @@ std::string ScoreFunction::get_details_str() const {
   return std::format("{}({})", name, args_str);
 }
 
+bool ScoreFunction::is_monotone() const {
+  if (const Expression *expression_kernel = std::get_if<Expression>(&kernel)) {
+    return expression_kernel->expression.is_monotone();
+  }
+  // Every other score function is a non-negative combination of yields, or a minimum of them.
+  return std::all_of(args.cbegin(), args.cend(), [](const auto &arg) { return arg.second >= 0; });
+}
+
 double ScoreFunction::operator()(const Layout &layout) const {
-  return score_function(layout);
+  const ResourceYield &resource_yield = layout.get_resource_yield();
+  return std::visit(
+      [&](const auto &kernel) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(kernel)>, Expression>) {
+          return kernel.expression(resource_yield);
+        } else {
+          return kernel(resource_yield.get_production(), resource_yield.get_revenue(), resource_yield.get_storage());
+        }
+      },
+      kernel);
+}
+
+void ScoreFunction::operator()(const ResourceYieldBatch &batch, std::span<double> scores) const {
+  std::visit(
+      [&](const auto &kernel) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(kernel)>, Expression>) {
+          kernel.expression(batch, scores);
+        } else {
+          score_lanes(kernel, batch, scores);
+        }
+      },
+      kernel);
 }
 
+void ScoreFunction::operator()(
+    const ResourceYieldBatch &batch,
+    const Constraints &constraints,
+    std::span<double> scores) const {
+  std::visit(
+      [&](const auto &kernel) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(kernel)>, Expression>) {
+          score_expression_lanes(kernel.expression, batch, constraints, scores);
+        } else {
+          score_lanes(kernel, batch, constraints, scores);
+        }
+      },
+      kernel);
+}
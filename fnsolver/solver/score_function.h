@@ -1,21 +1,30 @@
 #ifndef FNSOLVER_SOLVER_SCORE_FUNCTION_H
 #define FNSOLVER_SOLVER_SCORE_FUNCTION_H
 
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
 #include <fnsolver/layout/layout.h>
+#include <fnsolver/solver/score_expression.h>
 
-#include <functional>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <variant>
 
 class ScoreFunction {
   friend bool operator==(const ScoreFunction& lhs, const ScoreFunction& rhs) {
     return
       lhs.name == rhs.name
-      && lhs.args == rhs.args;
+      && lhs.args == rhs.args
+      && lhs.expression_text == rhs.expression_text;
   }
 
 public:
-  using func_t = std::function<double(const Layout &)>;
     // For serialization.
 
     using args_map_t = std::unordered_map<std::string, double>;
@@ -27,10 +36,38 @@ class ScoreFunction {
       max_revenue,
       max_storage,
       ratio,
-      weights
+      weights,
+      expression
     };
 
     static const std::unordered_map<std::string, Type> type_for_str;
+    /** Score function strings starting with this hold an expression, as in "expr:min(mining, storage)" */
+    static const std::string expression_prefix;
+
+    /** How layouts that miss any of the constraints' minimums are scored */
+    enum class ConstraintMode {
+      /** 0, however close they came */
+      zero,
+      /**
+       * Minus the sum of their shortfalls, each relative to its minimum. Every score function scores 0 or more, so
+       * they rank below every layout meeting the minimums, and above the layouts missing them by more.
+       */
+      penalty
+    };
+
+    static const std::unordered_map<std::string, ConstraintMode> constraint_mode_for_str;
+    static const std::unordered_map<ConstraintMode, std::string> str_for_constraint_mode;
+
+    /** Minimum yields a layout must reach to score as usual */
+    struct Constraints {
+      uint32_t production_minimum;
+      uint32_t revenue_minimum;
+      uint32_t storage_minimum;
+      std::array<uint32_t, precious_resource::count> precious_resource_minimums;
+      ConstraintMode mode;
+
+      bool are_met_by(const ResourceYield &resource_yield) const;
+    };
 
     static ScoreFunction create_max_mining();
     static ScoreFunction create_max_effective_mining(double storage_factor);
@@ -38,26 +75,92 @@ class ScoreFunction {
     static ScoreFunction create_max_storage();
     static ScoreFunction create_ratio(double mining_factor, double revenue_factor, double storage_factor);
     static ScoreFunction create_weights(double mining_weight, double revenue_weight, double storage_weight);
-    ScoreFunction(func_t score_function, std::string name, args_t args = {});
+    /** Throws std::invalid_argument if expression_text does not parse, see ScoreExpression */
+    static ScoreFunction create_expression(const std::string &expression_text);
 
     static ScoreFunction from_name_and_args(const std::string& name, const args_map_t& args);
     static ScoreFunction from_name_and_args(const std::string& name, const std::vector<double>& args);
-    ScoreFunction(const ScoreFunction &other);
+    ScoreFunction(const ScoreFunction &other) = default;
     ScoreFunction(ScoreFunction &&other) = default;
-    ScoreFunction &operator=(const ScoreFunction &other);
+    ScoreFunction &operator=(const ScoreFunction &other) = default;
     ScoreFunction &operator=(ScoreFunction &&other) = default;
 
     const std::string &get_name() const { return name; }
     const args_t &get_args() const { return args; }
+    /** Empty unless this is an expression */
+    const std::string &get_expression_text() const { return expression_text; }
     args_map_t get_args_map() const;
     std::string get_details_str() const; // just used for info output
+    /** Whether the score never decreases as any yield increases, which bounding scores relies on */
+    bool is_monotone() const;
     double operator()(const Layout &layout) const;
+    /** scores must have batch.size() elements */
+    void operator()(const ResourceYieldBatch &batch, std::span<double> scores) const;
+    /** Lanes that miss any of the constraints' minimums score as the constraints' mode says, in the same pass */
+    void operator()(const ResourceYieldBatch &batch, const Constraints &constraints, std::span<double> scores) const;
   private:
-    func_t score_function;
+    // Kernels score one layout's production, revenue, and storage. Being a closed set, every batch loop is compiled
+    // once per kernel with the kernel inlined, and only dispatched on once per batch.
+    struct MaxMining {
+      double operator()(uint32_t production, uint32_t /*revenue*/, uint32_t /*storage*/) const { return production; }
+    };
+    struct MaxEffectiveMining {
+      double storage_factor;
+
+      double operator()(uint32_t production, uint32_t /*revenue*/, uint32_t storage) const {
+        return std::min(storage_factor * production, static_cast<double>(storage));
+      }
+    };
+    struct MaxRevenue {
+      double operator()(uint32_t /*production*/, uint32_t revenue, uint32_t /*storage*/) const { return revenue; }
+    };
+    struct MaxStorage {
+      double operator()(uint32_t /*production*/, uint32_t /*revenue*/, uint32_t storage) const { return storage; }
+    };
+    struct Ratio {
+      /** Mining, revenue, storage, at least one of them positive */
+      std::array<double, 3> factors;
+      double max_factor;
+
+      double operator()(uint32_t production, uint32_t revenue, uint32_t storage) const {
+        const std::array<uint32_t, 3> values = {production, revenue, storage};
+        double min = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < factors.size(); ++i) {
+          if (factors[i] > 0) {
+            min = std::min(min, values[i] / factors[i]);
+          }
+        }
+        return min * max_factor;
+      }
+    };
+    /** Ratio without any positive factor */
+    struct Zero {
+      double operator()(uint32_t /*production*/, uint32_t /*revenue*/, uint32_t /*storage*/) const { return 0.0; }
+    };
+    struct Weights {
+      /** Mining, revenue, storage */
+      std::array<double, 3> weights;
+
+      double operator()(uint32_t production, uint32_t revenue, uint32_t storage) const {
+        return weights[0] * production + weights[1] * revenue + weights[2] * storage;
+      }
+    };
+    /** Unlike the other kernels, also reads precious resource quantities, so it scores lanes rather than yields */
+    struct Expression {
+      ScoreExpression expression;
+    };
+    using kernel_t =
+        std::variant<MaxMining, MaxEffectiveMining, MaxRevenue, MaxStorage, Ratio, Zero, Weights, Expression>;
+
+    ScoreFunction(kernel_t kernel, std::string name, args_t args = {}, std::string expression_text = {});
+
+    kernel_t kernel;
     // For serialization.
     std::string name;
     // For serialization.
     args_t args;
+    // For serialization.
+    std::string expression_text;
 };
 
 #endif // FNSOLVER_SOLVER_SCORE_FUNCTION_H
@@ -1,36 +1,51 @@
 #include <fnsolver/solver/solution.h>
 
+#include <fnsolver/data/fnsite.h>
 #include <fnsolver/data/probe.h>
 #include <fnsolver/layout/layout.h>
-#include <fnsolver/solver/score_function.h>
+#include <fnsolver/layout/layout_evaluator.h>
+#include <fnsolver/layout/placement.h>
 
+#include <compare>
 #include <cstdint>
-#include <optional>
+#include <utility>
 #include <vector>
 
+// static
+std::partial_ordering Solution::compare_scores(
+    double score,
+    double tiebreaker_score,
+    double other_score,
+    double other_tiebreaker_score) {
+  const std::partial_ordering score_comp = score <=> other_score;
+  return score_comp != 0 ? score_comp : tiebreaker_score <=> other_tiebreaker_score;
+}
+
 Solution::Solution(
-    Layout layout,
-    std::vector<const Probe *> unused_probes,
-    const ScoreFunction &score_function,
-    const std::optional<ScoreFunction> &maybe_tiebreaker_function)
-    : layout(std::move(layout)),
-      unused_probes(std::move(unused_probes)),
-      score(score_function(this->layout)),
-      tiebreaker_score([&, this]() {
-        if (maybe_tiebreaker_function) {
-          return (*maybe_tiebreaker_function)(this->layout);
-        } else {
-          return 0.0;
-        }
-      }()),
+    const LayoutEvaluator::probe_idxs_t &probe_idxs,
+    const probe_quantities_t &unused_probe_quantities,
+    double score,
+    double tiebreaker_score)
+    : probe_idxs(probe_idxs),
+      unused_probe_quantities(unused_probe_quantities),
+      score(score),
+      tiebreaker_score(tiebreaker_score),
       age(0) {}
 
-const Layout &Solution::get_layout() const {
-  return layout;
+const LayoutEvaluator::probe_idxs_t &Solution::get_probe_idxs() const {
+  return probe_idxs;
 }
 
-const std::vector<const Probe *> &Solution::get_unused_probes() const {
-  return unused_probes;
+const Solution::probe_quantities_t &Solution::get_unused_probe_quantities() const {
+  return unused_probe_quantities;
+}
+
+Layout Solution::create_layout() const {
+  std::vector<Placement> placements;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    placements.emplace_back(FnSite::sites[site_idx], Probe::probes[probe_idxs[site_idx]]);
+  }
+  return Layout(std::move(placements));
 }
 
 double Solution::get_score() const {
@@ -50,7 +65,5 @@ uint32_t &Solution::get_age() {
 }
 
 std::partial_ordering Solution::operator<=>(const Solution &other) const {
-  const std::partial_ordering score_comp = score <=> other.score;
-  return score_comp != 0 ? score_comp : tiebreaker_score <=> other.tiebreaker_score;
+  return compare_scores(score, tiebreaker_score, other.score, other.tiebreaker_score);
 }
-
@@ -3,28 +3,46 @@
 
 #include <fnsolver/data/probe.h>
 #include <fnsolver/layout/layout.h>
-#include <fnsolver/solver/score_function.h>
+#include <fnsolver/layout/layout_evaluator.h>
 
+#include <array>
 #include <compare>
 #include <cstdint>
-#include <optional>
-#include <vector>
 
+/**
+ * Compact genome of one individual in the population: a probe idx per site, counts of the inventory left unplaced,
+ * and its scores. Only a couple of hundred bytes, so the solver never keeps a full Layout per individual, see
+ * create_layout().
+ */
 class Solution {
   public:
+    using probe_quantities_t = std::array<uint32_t, Probe::num_probes>;
+
+    /** Orders by score, then tiebreaker score */
+    static std::partial_ordering compare_scores(
+        double score,
+        double tiebreaker_score,
+        double other_score,
+        double other_tiebreaker_score);
+
+    /** Scores are evaluated elsewhere, e.g. as part of a batch */
     Solution(
-        Layout layout,
-        std::vector<const Probe *> unused_probes,
-        const ScoreFunction &score_function,
-        const std::optional<ScoreFunction> &maybe_tiebreaker_function);
+        const LayoutEvaluator::probe_idxs_t &probe_idxs,
+        const probe_quantities_t &unused_probe_quantities,
+        double score,
+        double tiebreaker_score);
 
     Solution(const Solution &other) = default;
     Solution(Solution &&other) = default;
     Solution &operator=(const Solution &other) = default;
     Solution &operator=(Solution &&other) = default;
 
-    const Layout &get_layout() const;
-    const std::vector<const Probe *> &get_unused_probes() const;
+    /** Probe indices (into Probe::probes) ordered by site idx */
+    const LayoutEvaluator::probe_idxs_t &get_probe_idxs() const;
+    /** Unplaced probes of the inventory, indexed like Probe::probes */
+    const probe_quantities_t &get_unused_probe_quantities() const;
+    /** Evaluates the full layout, for reporting */
+    Layout create_layout() const;
 
     double get_score() const;
     double get_tiebreaker_score() const;
@@ -33,8 +51,8 @@ class Solution {
 
     std::partial_ordering operator<=>(const Solution &other) const;
   private:
-    Layout layout;
-    std::vector<const Probe *> unused_probes;
+    LayoutEvaluator::probe_idxs_t probe_idxs;
+    probe_quantities_t unused_probe_quantities;
 
     double score;
     double tiebreaker_score;
@@ -42,4 +60,3 @@ class Solution {
 };
 
 #endif // FNSOLVER_SOLVER_SOLUTION_H
-
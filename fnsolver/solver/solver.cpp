@@ -1,63 +1,46 @@
 #include <fnsolver/solver/solver.h>
 
 #include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
 #include <fnsolver/data/probe.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
 #include <fnsolver/layout/layout.h>
+#include <fnsolver/layout/layout_evaluator.h>
 #include <fnsolver/layout/placement.h>
+#include <fnsolver/solver/evaluation_cache.h>
 #include <fnsolver/solver/options.h>
+#include <fnsolver/solver/presolve.h>
 #include <fnsolver/solver/solution.h>
+#include <fnsolver/util/arena.hpp>
+#include <fnsolver/util/random.hpp>
+#include <fnsolver/util/seqlock.hpp>
+#include <fnsolver/util/work_stealing_scheduler.hpp>
+#include <fnsolver/util/worker_pool.hpp>
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <csignal>
 #include <cstdint>
 #include <format>
-#include <future>
+#include <limits>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <numeric>
 #include <optional>
 #include <ostream>
 #include <random>
+#include <span>
 #include <string>
-#include <thread>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 namespace {
-ScoreFunction create_constrained_score_function(const Options &options) {
-  const std::vector<size_t> nonzero_precious_resource_minimum_idxs = [&]() {
-    std::vector<size_t> nonzero_precious_resource_minimum_idxs;
-    for (size_t i = 0; i < options.get_precious_resource_minimums().size(); ++i) {
-      if (options.get_precious_resource_minimums().at(i) != 0) {
-        nonzero_precious_resource_minimum_idxs.push_back(i);
-      }
-    }
-    return nonzero_precious_resource_minimum_idxs;
-  }();
-
-  return ScoreFunction(
-      [&options, nonzero_precious_resource_minimum_idxs](const Layout &layout) {
-        const std::array<uint32_t, precious_resource::count> &precious_resource_quantities
-            = layout.get_resource_yield().get_precious_resource_quantities();
-        const std::array<uint32_t, precious_resource::count> &precious_resource_minimums
-            = options.get_precious_resource_minimums();
-        for (const size_t idx : nonzero_precious_resource_minimum_idxs) {
-          if (precious_resource_quantities.at(idx) < precious_resource_minimums.at(idx)) {
-            return 0.0;
-          }
-        }
-
-        if (layout.get_resource_yield().get_production() < options.get_production_minimum()
-            || layout.get_resource_yield().get_revenue() < options.get_revenue_minimum()
-            || layout.get_resource_yield().get_storage() < options.get_storage_minimum()) {
-          return 0.0;
-        }
-
-        return options.get_score_function()(layout);
-      },
-      options.get_score_function().get_name(), options.get_score_function().get_args());
-}
-
 std::vector<Placement> merge_locked_sites_and_seed(const Options &options) {
   std::vector<Placement> merged_seed;
   const std::vector<Placement> &locked_sites = options.get_locked_sites();
@@ -75,7 +58,14 @@ std::vector<Placement> merge_locked_sites_and_seed(const Options &options) {
 
 Solver::Solver(Options options)
     : options(std::move(options)),
-      constrained_score_function(create_constrained_score_function(this->options)),
+      constraints({
+        .production_minimum = this->options.get_production_minimum(),
+        .revenue_minimum = this->options.get_revenue_minimum(),
+        .storage_minimum = this->options.get_storage_minimum(),
+        .precious_resource_minimums = this->options.get_precious_resource_minimums(),
+        .mode = this->options.get_constraint_mode(),
+      }),
+      presolve(this->options),
       merged_locked_sites_and_seed(merge_locked_sites_and_seed(this->options)),
       site_idx_is_seeded([this]() {
         std::vector<bool> site_idx_is_seeded(FnSite::sites.size(), false);
@@ -84,6 +74,37 @@ Solver::Solver(Options options)
         }
         return site_idx_is_seeded;
       }()),
+      mutable_site_idxs(presolve.get_mutable_site_idxs()),
+      constrained_precious_resource_idxs([this]() {
+        std::vector<size_t> constrained_precious_resource_idxs;
+        for (size_t idx = 0; idx < precious_resource::count; ++idx) {
+          if (this->options.get_precious_resource_minimums()[idx] > 0) {
+            constrained_precious_resource_idxs.push_back(idx);
+          }
+        }
+        return constrained_precious_resource_idxs;
+      }()),
+      repair_site_idxs([this]() {
+        std::vector<size_t> repair_site_idxs;
+        for (const size_t site_idx : mutable_site_idxs) {
+          const std::array<uint32_t, precious_resource::count> &site_quantities
+              = FnSite::sites[site_idx].precious_resource_quantities;
+          if (std::any_of(
+              constrained_precious_resource_idxs.cbegin(),
+              constrained_precious_resource_idxs.cend(),
+              [&](size_t idx) { return site_quantities[idx] > 0; })) {
+            repair_site_idxs.push_back(site_idx);
+          }
+        }
+        return repair_site_idxs;
+      }()),
+      site_idx_is_forced_collecting([this]() {
+        std::vector<bool> site_idx_is_forced_collecting(FnSite::num_sites, false);
+        for (const size_t site_idx : presolve.get_forced_collecting_site_idxs()) {
+          site_idx_is_forced_collecting[site_idx] = true;
+        }
+        return site_idx_is_forced_collecting;
+      }()),
       inventory([this]() {
         std::vector<const Probe *> inventory;
         for (size_t probe_id = 0; probe_id < this->options.get_probe_quantities().size(); ++probe_id) {
@@ -96,78 +117,150 @@ Solver::Solver(Options options)
       }()) {}
 
 Solution Solver::run(const ProgressCallback& progress_callback, const StopCallback& stop_callback) const {
-  std::mt19937 mt_engine(std::random_device{}());
+  util::WorkerPool worker_pool(options.get_num_threads());
+
+  // Every solution draws from its own stream for each iteration, so no result depends on which worker it ran on.
+  const uint64_t rng_seed = [this]() {
+    if (options.get_maybe_rng_seed()) {
+      return *options.get_maybe_rng_seed();
+    }
+    std::random_device random_device;
+    return (uint64_t(random_device()) << 32) | random_device();
+  }();
+  const auto random_engine_for = [rng_seed](uint32_t iteration, size_t solution_idx) {
+    return util::Xoshiro256PlusPlus(rng_seed, (uint64_t(iteration) << 32) | solution_idx);
+  };
+
+  // one per worker, kept across iterations
+  std::vector<EvaluationCache> evaluation_caches(worker_pool.size());
+  // reset after every solution, so each only grows until it fits the most any solution's offspring ever needed
+  std::vector<util::Arena> arenas(worker_pool.size());
+
+  // one contiguous slice of the initial population per worker
+  const auto population_start_idx = [&](size_t worker_idx) {
+    return (worker_idx * options.get_population_size()) / worker_pool.size();
+  };
+
   std::vector<Solution> population;
-  for (uint32_t i = 0; i < options.get_population_size(); ++i) {
-    population.emplace_back(create_random_solution(mt_engine));
+  {
+    std::vector<std::vector<Solution>> worker_populations(worker_pool.size());
+    worker_pool.run([&](size_t worker_idx) {
+      for (size_t i = population_start_idx(worker_idx); i < population_start_idx(worker_idx + 1); ++i) {
+        util::Xoshiro256PlusPlus random_engine = random_engine_for(0, i);
+        worker_populations[worker_idx].emplace_back(create_random_solution(random_engine, arenas[worker_idx]));
+        arenas[worker_idx].reset();
+      }
+    });
+    for (std::vector<Solution> &worker_population : worker_populations) {
+      std::move(worker_population.begin(), worker_population.end(), std::back_inserter(population));
+    }
   }
 
+  // Dealt out like the initial population, but in chunks that idle workers steal once their own run out.
+  util::WorkStealingScheduler scheduler(worker_pool.size());
+  const size_t chunk_size = options.get_population_size() / (worker_pool.size() * chunks_per_worker);
+
+  std::vector<size_t> worker_num_killed(worker_pool.size());
+  std::vector<OffspringStats> worker_offspring_stats(worker_pool.size());
+  std::vector<std::chrono::steady_clock::duration> worker_busy_durations(worker_pool.size());
+  std::vector<size_t> worker_num_steals(worker_pool.size());
+  std::vector<size_t> worker_num_allocations(worker_pool.size());
+
   Solution best_solution = population.at(0); // doesn't really matter, so don't calculate actual max
   uint32_t last_improvement_iteration = 0;
+  const auto publish_best_solution = [&]() {
+    Layout layout = best_solution.create_layout();
+    layout.get_resolved_placements(); // resolved up front, so readers never fill the lazy cache concurrently
+    const bool meets_constraints = constraints.are_met_by(layout.get_resource_yield());
+    best_snapshot.store(std::make_shared<const BestSnapshot>(BestSnapshot{
+      .solution = best_solution,
+      .layout = std::move(layout),
+      .iteration = last_improvement_iteration,
+      .meets_constraints = meets_constraints,
+    }));
+  };
+  publish_best_solution();
+  util::SeqLock<Solution> global_best(best_solution);
   uint32_t iteration = 0;
   do { // run one iteration even if the user terminated before it started, so that there's some meaningful result
     ++iteration;
 
-    std::vector<Solution> new_generation;
-    size_t num_killed = 0;
-
-    std::vector<std::thread> threads;
-    std::vector<std::future<std::pair<std::vector<Solution>, size_t>>> futures;
-    for (uint32_t thread_idx = 0; thread_idx < options.get_num_threads(); ++thread_idx) {
-      std::promise<std::pair<std::vector<Solution>, size_t>> promise;
-      futures.emplace_back(promise.get_future());
-
-      threads.emplace_back([&, thread_idx](std::promise<std::pair<std::vector<Solution>, size_t>> ret) {
-        std::mt19937 thread_mt_engine(std::random_device{}());
-
-        std::vector<Solution> thread_new_generation;
-        size_t thread_num_killed = 0;
-
-        const size_t start_idx = (thread_idx * options.get_population_size()) / options.get_num_threads();
-        const size_t end_idx = ((thread_idx + 1) * options.get_population_size()) / options.get_num_threads();
-        for (size_t solution_idx = start_idx; solution_idx < end_idx; ++solution_idx) {
-          Solution &solution = population[solution_idx];
-
-          auto [best_child, killed_flag]
-              = create_solution_children_and_find_best(std::move(solution), best_solution, thread_mt_engine);
-
-          thread_new_generation.emplace_back(std::move(best_child));
+    // Children replace their parent in place, each solution is in exactly one chunk.
+    scheduler.reset(population.size(), chunk_size);
+    const std::chrono::steady_clock::time_point iteration_start = std::chrono::steady_clock::now();
+    worker_pool.run([&](size_t worker_idx) {
+      const std::chrono::steady_clock::time_point worker_start = std::chrono::steady_clock::now();
+      worker_num_killed[worker_idx] = 0;
+      worker_offspring_stats[worker_idx] = {};
+      worker_num_steals[worker_idx] = 0;
+      const size_t num_allocations_before = arenas[worker_idx].get_num_allocations();
+      while (const std::optional<util::WorkStealingScheduler::Chunk> maybe_chunk = scheduler.next(worker_idx)) {
+        if (maybe_chunk->stolen) {
+          ++worker_num_steals[worker_idx];
+        }
+        for (size_t solution_idx = maybe_chunk->start_idx; solution_idx < maybe_chunk->end_idx; ++solution_idx) {
+          util::Xoshiro256PlusPlus random_engine = random_engine_for(iteration, solution_idx);
+          auto [best_child, killed_flag, solution_offspring_stats] = create_solution_children_and_find_best(
+              std::move(population[solution_idx]),
+              global_best,
+              evaluation_caches[worker_idx],
+              random_engine,
+              arenas[worker_idx]);
+          arenas[worker_idx].reset();
+
+          population[solution_idx] = std::move(best_child);
           if (killed_flag) {
-            ++thread_num_killed;
+            ++worker_num_killed[worker_idx];
           }
+          worker_offspring_stats[worker_idx] += solution_offspring_stats;
         }
-
-        ret.set_value({std::move(thread_new_generation), thread_num_killed});
-      }, std::move(promise));
-    }
-
-    for (size_t thread_idx = 0; thread_idx < threads.size(); ++thread_idx) {
-      threads[thread_idx].join();
-      auto [thread_new_generation, thread_num_killed] = futures[thread_idx].get();
-
-      for (Solution &solution : thread_new_generation) {
-        new_generation.emplace_back(std::move(solution));
       }
-      num_killed += thread_num_killed;
-    }
-    threads.clear();
-    futures.clear();
+      worker_num_allocations[worker_idx] = arenas[worker_idx].get_num_allocations() - num_allocations_before;
+      worker_busy_durations[worker_idx] = std::chrono::steady_clock::now() - worker_start;
+    });
+    const std::chrono::steady_clock::duration iteration_duration = std::chrono::steady_clock::now() - iteration_start;
 
-    population = std::move(new_generation);
+    size_t num_killed = 0;
+    OffspringStats offspring_stats{};
+    std::vector<WorkerStatus> worker_statuses;
+    for (size_t worker_idx = 0; worker_idx < worker_pool.size(); ++worker_idx) {
+      num_killed += worker_num_killed[worker_idx];
+      offspring_stats += worker_offspring_stats[worker_idx];
+      worker_statuses.push_back({
+        .utilization = iteration_duration.count() == 0
+          ? 1.0
+          : std::min(1.0, std::chrono::duration<double>(worker_busy_durations[worker_idx])
+              / std::chrono::duration<double>(iteration_duration)),
+        .num_steals = worker_num_steals[worker_idx],
+        .num_allocations = worker_num_allocations[worker_idx],
+      });
+    }
 
     const std::vector<Solution>::const_iterator population_best_it
         = std::max_element(population.cbegin(), population.cend());
     if (*population_best_it > best_solution) {
       best_solution = *population_best_it;
       last_improvement_iteration = iteration;
+      publish_best_solution();
+      global_best.store_if(best_solution, [&](const Solution &global_best_solution) {
+        return best_solution > global_best_solution;
+      });
     }
 
     progress_callback({
       .iteration = iteration,
       .best_score = best_solution.get_score(),
       .num_killed = num_killed,
+      .num_rejected = offspring_stats.num_rejected,
+      .num_repair_attempts = offspring_stats.num_repair_attempts,
+      .num_repaired = offspring_stats.num_repaired,
+      .num_pruned = offspring_stats.num_pruned,
+      .num_unchanged = offspring_stats.num_unchanged,
+      .num_cache_lookups = offspring_stats.num_cache_lookups,
+      .num_cache_hits = offspring_stats.num_cache_hits,
+      .worker_statuses = std::move(worker_statuses),
       .last_improvement = last_improvement_iteration,
-      .best_layout = best_solution.get_layout(),
+      .best_snapshot = best_snapshot.load(),
     });
   }
   while (!stop_callback()
@@ -177,120 +270,583 @@ Solution Solver::run(const ProgressCallback& progress_callback, const StopCallba
   return best_solution;
 }
 
-Solution Solver::create_random_solution(std::mt19937 &mt_engine) const {
-  std::vector<const Probe *> inventory_copy = inventory;
-  std::shuffle(inventory_copy.begin(), inventory_copy.end(), mt_engine);
+std::shared_ptr<const Solver::BestSnapshot> Solver::get_best_snapshot() const {
+  return best_snapshot.load();
+}
+
+Solution Solver::create_random_solution(util::Xoshiro256PlusPlus &random_engine, util::Arena &arena) const {
+  std::pmr::vector<const Probe *> inventory_copy(inventory.cbegin(), inventory.cend(), &arena);
+  std::shuffle(inventory_copy.begin(), inventory_copy.end(), random_engine);
 
-  std::vector<Placement> placements;
+  LayoutEvaluator::probe_idxs_t probe_idxs;
   size_t probe_idx = 0;
   for (size_t site_idx = 0, seed_idx = 0; site_idx < FnSite::sites.size(); ++site_idx) {
     if (site_idx_is_seeded[site_idx]) {
-      placements.emplace_back(merged_locked_sites_and_seed[seed_idx]);
+      probe_idxs[site_idx] =
+          static_cast<LayoutEvaluator::probe_idx_t>(merged_locked_sites_and_seed[seed_idx].get_probe().probe_id);
       ++seed_idx;
     } else {
-      placements.emplace_back(FnSite::sites[site_idx], *inventory_copy[probe_idx]);
+      probe_idxs[site_idx] = static_cast<LayoutEvaluator::probe_idx_t>(inventory_copy[probe_idx]->probe_id);
       ++probe_idx;
     }
   }
 
-  std::vector<const Probe *> unused_probes;
+  // Mutations never take a collecting probe off a forced site, so every solution has to start out with one there.
+  // The presolve never forces more sites than there are collecting probes, and none at all if it's infeasible.
+  for (const size_t site_idx : presolve.get_forced_collecting_site_idxs()) {
+    if (LayoutEvaluator::collects_precious_resources(probe_idxs[site_idx])) {
+      continue;
+    }
+
+    const auto unused_it = std::find_if(
+        inventory_copy.begin() + static_cast<std::ptrdiff_t>(probe_idx),
+        inventory_copy.end(),
+        [](const Probe *probe) { return LayoutEvaluator::collects_precious_resources(probe->probe_id); });
+    if (unused_it != inventory_copy.end()) {
+      const Probe *unused_probe = *unused_it;
+      *unused_it = &Probe::probes[probe_idxs[site_idx]];
+      probe_idxs[site_idx] = static_cast<LayoutEvaluator::probe_idx_t>(unused_probe->probe_id);
+      continue;
+    }
+    const auto source_it = std::find_if(
+        mutable_site_idxs.cbegin(),
+        mutable_site_idxs.cend(),
+        [&](size_t source_site_idx) {
+          return !site_idx_is_forced_collecting[source_site_idx]
+              && LayoutEvaluator::collects_precious_resources(probe_idxs[source_site_idx]);
+        });
+    if (source_it != mutable_site_idxs.cend()) {
+      std::swap(probe_idxs[site_idx], probe_idxs[*source_it]);
+    }
+  }
+
+  Solution::probe_quantities_t unused_probe_quantities;
+  unused_probe_quantities.fill(0);
   for (; probe_idx < inventory_copy.size(); ++probe_idx) {
-    unused_probes.push_back(inventory_copy[probe_idx]);
+    ++unused_probe_quantities[inventory_copy[probe_idx]->probe_id];
   }
 
-  return Solution(
-      std::move(placements),
-      std::move(unused_probes),
-      constrained_score_function,
-      options.get_maybe_tiebreaker_function());
+  // scored like any child, rather than through a Layout, so nothing leaves the arena
+  LayoutEvaluator evaluator;
+  evaluator.evaluate(probe_idxs);
+  ResourceYieldBatch resource_yields(&arena);
+  resource_yields.push_back(evaluator.get_resource_yield());
+  double score;
+  double tiebreaker_score = 0.0;
+  options.get_score_function()(resource_yields, constraints, std::span<double>(&score, 1));
+  if (options.get_maybe_tiebreaker_function()) {
+    (*options.get_maybe_tiebreaker_function())(resource_yields, std::span<double>(&tiebreaker_score, 1));
+  }
+
+  return Solution(probe_idxs, unused_probe_quantities, score, tiebreaker_score);
 }
 
-std::pair<Solution, bool> Solver::create_solution_children_and_find_best(
+std::tuple<Solution, bool, Solver::OffspringStats> Solver::create_solution_children_and_find_best(
     Solution solution,
-    const Solution &best_solution,
-    std::mt19937 &mt_engine) const {
-  Solution best_child = create_solution_mutation(solution, mt_engine);
-  for (size_t i = 0; i < options.get_num_offspring() - 1; ++i) {
-    Solution child = create_solution_mutation(solution, mt_engine);
-    if (child > best_child) {
-      best_child = std::move(child);
-    }
+    util::SeqLock<Solution> &global_best,
+    EvaluationCache &evaluation_cache,
+    util::Xoshiro256PlusPlus &random_engine,
+    util::Arena &arena) const {
+  // A child only matters if it beats the solution, and can't score more than an upper bound on its yield does.
+  const bool bound_children = solution.get_score() > 0 && options.get_score_function().is_monotone();
+  // Penalized children missing the constraints score below 0, so only a solution scoring below 0 may lose to one.
+  const bool reject_misses = constraints.mode == ScoreFunction::ConstraintMode::zero || solution.get_score() >= 0;
+
+  // The solution only keeps its probes, so resolve its evaluation once to derive each child's from
+  LayoutEvaluator evaluator;
+  evaluator.evaluate(solution.get_probe_idxs());
+
+  // how many free sites hold each probe, shared by every mutation of the solution
+  Solution::probe_quantities_t free_site_probe_quantities;
+  free_site_probe_quantities.fill(0);
+  for (const size_t site_idx : mutable_site_idxs) {
+    ++free_site_probe_quantities[solution.get_probe_idxs()[site_idx]];
   }
 
-  bool improved = best_child > solution;
-  if (!improved) {
-    best_child = std::move(solution);
-  }
+  // Everything below only lives until the best child is found, so it all comes from the arena, sized up front.
+  OffspringStats stats{};
+  std::pmr::vector<Mutation> mutations(&arena);
+  std::pmr::vector<uint64_t> hashes(&arena);
+  std::pmr::vector<double> scores(&arena);
+  std::pmr::vector<double> tiebreaker_scores(&arena);
+  std::pmr::vector<bool> is_scored(&arena);
+  std::pmr::vector<bool> has_tiebreaker_scores(&arena);
+  std::pmr::vector<double> bound_scores(&arena);
+  std::pmr::vector<size_t> bound_idxs(&arena); // mutations whose bound is in bound_resource_yields
+  ResourceYieldBatch bound_resource_yields(&arena);
+  mutations.reserve(options.get_num_offspring());
+  hashes.reserve(options.get_num_offspring());
+  scores.reserve(options.get_num_offspring());
+  tiebreaker_scores.reserve(options.get_num_offspring());
+  is_scored.reserve(options.get_num_offspring());
+  has_tiebreaker_scores.reserve(options.get_num_offspring());
+  bound_scores.reserve(options.get_num_offspring());
+  bound_idxs.reserve(options.get_num_offspring());
+  bound_resource_yields.reserve(options.get_num_offspring());
+  // Children are only kept as their changes, and put on these in turn whenever the evaluator needs a child's probes
+  LayoutEvaluator::probe_idxs_t child_probe_idxs = solution.get_probe_idxs();
+  Solution::probe_quantities_t child_unused_probe_quantities = solution.get_unused_probe_quantities();
+  for (size_t i = 0; i < options.get_num_offspring(); ++i) {
+    ChangedSites changed_sites = create_solution_mutation(
+        free_site_probe_quantities,
+        child_probe_idxs,
+        child_unused_probe_quantities,
+        random_engine);
+    if (changed_sites.num_site_idxs == 0) {
+      ++stats.num_unchanged; // same layout as the solution, so can't beat it
+      continue;
+    }
 
-  if (best_child.get_score() == 0) {
-    best_child.get_age() += 5; // rapidly age solutions that fail constraints
-  } else if (!improved && best_child < best_solution) {
-    best_child.get_age() += 1; // age solutions that aren't an improvement so long as they aren't the global best
+    // Precious resources don't depend on chains or boosts, so check them before paying for a full evaluation.
+    std::array<uint32_t, precious_resource::count> precious_resource_quantities
+        = evaluator.get_precious_resource_quantities_for(child_probe_idxs, changed_sites.get_site_idxs());
+    bool meets_precious_resource_minimums = true;
+    for (size_t idx = 0; idx < precious_resource::count; ++idx) {
+      if (precious_resource_quantities[idx] < options.get_precious_resource_minimums()[idx]) {
+        meets_precious_resource_minimums = false;
+        break;
+      }
+    }
+    if (!meets_precious_resource_minimums && options.get_repair_offspring()) {
+      ++stats.num_repair_attempts;
+      meets_precious_resource_minimums = repair_solution_mutation(
+          changed_sites,
+          child_probe_idxs,
+          child_unused_probe_quantities,
+          precious_resource_quantities);
+      if (meets_precious_resource_minimums) {
+        ++stats.num_repaired;
+      }
+    }
+    const bool is_rejected = reject_misses && !meets_precious_resource_minimums;
+    const Mutation mutation = Mutation::create(changed_sites.get_site_idxs(), child_probe_idxs, arena);
+
+    const uint64_t hash = evaluator.get_hash_for(child_probe_idxs, mutation.get_changed_site_idxs());
+    std::optional<EvaluationCache::Scores> maybe_cached_scores;
+    std::optional<ResourceYield> maybe_resource_yield_bound;
+    if (!is_rejected) {
+      maybe_cached_scores = evaluation_cache.find(hash);
+      if (!maybe_cached_scores && bound_children) {
+        maybe_resource_yield_bound
+            = evaluator.get_resource_yield_bound_for(child_probe_idxs, mutation.get_changed_site_idxs());
+      }
+    }
+    mutation.revert(child_probe_idxs, child_unused_probe_quantities, solution.get_probe_idxs());
+
+    if (is_rejected) {
+      ++stats.num_rejected;
+      continue;
+    }
+
+    // A hit only counts if it saves evaluating the child: an exact score, or a bound that prunes it right away
+    ++stats.num_cache_lookups;
+    const bool is_cached_exactly = maybe_cached_scores && !maybe_cached_scores->is_bound;
+    if (maybe_cached_scores && maybe_cached_scores->is_bound && bound_children
+        && maybe_cached_scores->score < solution.get_score()) {
+      ++stats.num_cache_hits;
+      ++stats.num_pruned;
+      continue;
+    }
+    if (is_cached_exactly) {
+      ++stats.num_cache_hits;
+    }
+
+    double bound_score = std::numeric_limits<double>::max();
+    if (maybe_cached_scores && maybe_cached_scores->is_bound) {
+      bound_score = maybe_cached_scores->score;
+    } else if (maybe_resource_yield_bound) {
+      bound_idxs.push_back(mutations.size());
+      bound_resource_yields.push_back(*maybe_resource_yield_bound);
+    }
+
+    mutations.push_back(mutation);
+    hashes.push_back(hash);
+    scores.push_back(is_cached_exactly ? maybe_cached_scores->score : 0.0);
+    tiebreaker_scores.push_back(is_cached_exactly ? maybe_cached_scores->tiebreaker_score : 0.0);
+    is_scored.push_back(is_cached_exactly);
+    has_tiebreaker_scores.push_back(is_cached_exactly && maybe_cached_scores->has_tiebreaker_score);
+    bound_scores.push_back(bound_score);
   }
 
-  if (best_child.get_age() >= options.get_max_age()) {
-    return {create_random_solution(mt_engine), true};
-  } else {
-    return {std::move(best_child), false};
+  if (!bound_idxs.empty()) {
+    std::pmr::vector<double> new_bound_scores(bound_idxs.size(), &arena);
+    options.get_score_function()(bound_resource_yields, new_bound_scores);
+    for (size_t bound_pos = 0; bound_pos < bound_idxs.size(); ++bound_pos) {
+      const size_t idx = bound_idxs[bound_pos];
+      bound_scores[idx] = new_bound_scores[bound_pos];
+      evaluation_cache.insert(
+          hashes[idx],
+          {.score = bound_scores[idx], .tiebreaker_score = 0.0, .has_tiebreaker_score = false, .is_bound = true});
+    }
   }
-}
 
-Solution Solver::create_solution_mutation(const Solution &solution, std::mt19937 &mt_engine) const {
-  std::bernoulli_distribution should_mutate(options.get_mutation_rate());
-
-  std::vector<Placement> new_placements = solution.get_layout().get_placements();
-  std::vector<const Probe *> new_unused_probes = solution.get_unused_probes();
-  bool mutated = false;
-  const size_t placements_size = new_placements.size();
-  const size_t inventory_size = placements_size + new_unused_probes.size();
-  for (size_t i = 0; i < inventory_size; ++i) {
-    const bool i_in_placements = i < placements_size;
-    const Probe &probe_i = i_in_placements ? new_placements[i].get_probe() : *new_unused_probes[i - placements_size];
-    if (i_in_placements
-        && site_idx_is_seeded[i]
-        && (options.get_force_seed() || probe_i.probe_type == Probe::Type::none)) {
+  std::pmr::vector<size_t> evaluated_idxs(&arena);
+  ResourceYieldBatch evaluated_resource_yields(&arena);
+  evaluated_idxs.reserve(mutations.size());
+  evaluated_resource_yields.reserve(mutations.size());
+  LayoutEvaluator child_evaluator;
+  for (size_t idx = 0; idx < mutations.size(); ++idx) {
+    if (is_scored[idx]) {
+      continue;
+    }
+    if (bound_children && bound_scores[idx] < solution.get_score()) {
+      ++stats.num_pruned;
       continue;
     }
 
-    if (should_mutate(mt_engine)) {
-      std::uniform_int_distribution<size_t> get_mutation_idx(0, inventory_size - 1);
-      const size_t j = get_mutation_idx(mt_engine);
-      const bool j_in_placements = j < placements_size;
-      const Probe &probe_j = j_in_placements ? new_placements[j].get_probe() : *new_unused_probes[j - placements_size];
-      if (j_in_placements
-          && site_idx_is_seeded[j]
-          && (options.get_force_seed() || probe_j.probe_type == Probe::Type::none)) {
-        continue;
-      }
+    const Mutation &mutation = mutations[idx];
+    mutation.apply(child_probe_idxs, child_unused_probe_quantities);
+    child_evaluator = evaluator;
+    child_evaluator.reevaluate(child_probe_idxs, mutation.get_changed_site_idxs());
+    mutation.revert(child_probe_idxs, child_unused_probe_quantities, solution.get_probe_idxs());
+    evaluated_idxs.push_back(idx);
+    evaluated_resource_yields.push_back(child_evaluator.get_resource_yield());
+  }
+
+  // Without a tiebreaker function every tiebreaker score is 0, otherwise they're only computed for ties below.
+  const bool has_tiebreaker_function = options.get_maybe_tiebreaker_function().has_value();
+  std::pmr::vector<double> evaluated_scores(evaluated_idxs.size(), &arena);
+  options.get_score_function()(evaluated_resource_yields, constraints, evaluated_scores);
+  for (size_t evaluated_pos = 0; evaluated_pos < evaluated_idxs.size(); ++evaluated_pos) {
+    const size_t idx = evaluated_idxs[evaluated_pos];
+    scores[idx] = evaluated_scores[evaluated_pos];
+    is_scored[idx] = true;
+    has_tiebreaker_scores[idx] = !has_tiebreaker_function;
+    evaluation_cache.insert(
+        hashes[idx],
+        {
+          .score = scores[idx],
+          .tiebreaker_score = 0.0,
+          .has_tiebreaker_score = !has_tiebreaker_function,
+          .is_bound = false,
+        });
+  }
 
-      if (&probe_i == &probe_j) {
+  // Only children with the best score, if it's at least the solution's, can win on tiebreaker, or need one to compare
+  // against later, so no other child ever computes one.
+  std::optional<double> maybe_best_score;
+  for (size_t idx = 0; idx < mutations.size(); ++idx) {
+    if (is_scored[idx] && (!maybe_best_score || scores[idx] > *maybe_best_score)) {
+      maybe_best_score = scores[idx];
+    }
+  }
+  if (has_tiebreaker_function && maybe_best_score && *maybe_best_score >= solution.get_score()) {
+    std::pmr::vector<size_t> tied_idxs(&arena);
+    ResourceYieldBatch tied_resource_yields(&arena);
+    for (size_t idx = 0; idx < mutations.size(); ++idx) {
+      if (!is_scored[idx] || has_tiebreaker_scores[idx] || scores[idx] != *maybe_best_score) {
         continue;
       }
 
-      if (i_in_placements) {
-        new_placements[i] = Placement(new_placements[i].get_site(), probe_j);
+      const std::pmr::vector<size_t>::const_iterator evaluated_it
+          = std::lower_bound(evaluated_idxs.cbegin(), evaluated_idxs.cend(), idx);
+      if (evaluated_it != evaluated_idxs.cend() && *evaluated_it == idx) {
+        tied_resource_yields.push_back(evaluated_resource_yields, evaluated_it - evaluated_idxs.cbegin());
       } else {
-        new_unused_probes[i - placements_size] = &probe_j;
+        // cached before its score ever tied, so its yield has to be evaluated after all
+        const Mutation &mutation = mutations[idx];
+        mutation.apply(child_probe_idxs, child_unused_probe_quantities);
+        child_evaluator = evaluator;
+        child_evaluator.reevaluate(child_probe_idxs, mutation.get_changed_site_idxs());
+        mutation.revert(child_probe_idxs, child_unused_probe_quantities, solution.get_probe_idxs());
+        tied_resource_yields.push_back(child_evaluator.get_resource_yield());
       }
+      tied_idxs.push_back(idx);
+    }
 
-      if (j_in_placements) {
-        new_placements[j] = Placement(new_placements[j].get_site(), probe_i);
-      } else {
-        new_unused_probes[j - placements_size] = &probe_i;
-      }
+    std::pmr::vector<double> tied_tiebreaker_scores(tied_idxs.size(), &arena);
+    (*options.get_maybe_tiebreaker_function())(tied_resource_yields, tied_tiebreaker_scores);
+    for (size_t tied_pos = 0; tied_pos < tied_idxs.size(); ++tied_pos) {
+      const size_t idx = tied_idxs[tied_pos];
+      tiebreaker_scores[idx] = tied_tiebreaker_scores[tied_pos];
+      has_tiebreaker_scores[idx] = true;
+      evaluation_cache.insert(
+          hashes[idx],
+          {
+            .score = scores[idx],
+            .tiebreaker_score = tiebreaker_scores[idx],
+            .has_tiebreaker_score = true,
+            .is_bound = false,
+          });
+    }
+  }
 
-      mutated = true;
+  std::optional<size_t> maybe_best_idx;
+  for (size_t idx = 0; idx < mutations.size(); ++idx) {
+    if (is_scored[idx]
+        && (!maybe_best_idx
+          || Solution::compare_scores(
+              scores[idx],
+              tiebreaker_scores[idx],
+              scores[*maybe_best_idx],
+              tiebreaker_scores[*maybe_best_idx]) > 0)) {
+      maybe_best_idx = idx;
     }
   }
 
-  if (mutated) {
+  // skipped children are never evaluated, so never replace the solution, even on tiebreaker
+  const bool improved = maybe_best_idx
+      && Solution::compare_scores(
+          scores[*maybe_best_idx],
+          tiebreaker_scores[*maybe_best_idx],
+          solution.get_score(),
+          solution.get_tiebreaker_score()) > 0;
+  Solution best_child = [&]() {
+    if (!improved) {
+      return std::move(solution);
+    }
+
+    // the only child that's ever materialized
+    mutations[*maybe_best_idx].apply(child_probe_idxs, child_unused_probe_quantities);
     return Solution(
-        Layout(std::move(new_placements)),
-        std::move(new_unused_probes),
-        constrained_score_function,
-        options.get_maybe_tiebreaker_function());
+        child_probe_idxs,
+        child_unused_probe_quantities,
+        scores[*maybe_best_idx],
+        tiebreaker_scores[*maybe_best_idx]);
+  }();
+
+  // Unless shared, this only changes between iterations, so results don't depend on which thread got there first.
+  if (improved && options.get_share_best()) {
+    global_best.store_if(best_child, [&](const Solution &global_best_solution) {
+      return best_child > global_best_solution;
+    });
+  }
+
+  if (best_child.get_score() == 0 && constraints.mode == ScoreFunction::ConstraintMode::zero) {
+    best_child.get_age() += 5; // rapidly age solutions that fail constraints, as they have nothing to climb
+  } else if (!improved && best_child < global_best.load()) {
+    best_child.get_age() += 1; // age solutions that aren't an improvement so long as they aren't the global best
+  }
+
+  if (best_child.get_age() >= options.get_max_age()) {
+    return {create_random_solution(random_engine, arena), true, stats};
   } else {
-    return solution;
+    return {std::move(best_child), false, stats};
+  }
+}
+
+// static
+Solver::Mutation Solver::Mutation::create(
+    std::span<const size_t> changed_site_idxs,
+    const LayoutEvaluator::probe_idxs_t &probe_idxs,
+    util::Arena &arena) {
+  std::pmr::polymorphic_allocator<> allocator(&arena);
+  size_t *site_idxs = allocator.allocate_object<size_t>(changed_site_idxs.size());
+  LayoutEvaluator::probe_idx_t *new_probe_idxs
+      = allocator.allocate_object<LayoutEvaluator::probe_idx_t>(changed_site_idxs.size());
+  for (size_t change_idx = 0; change_idx < changed_site_idxs.size(); ++change_idx) {
+    site_idxs[change_idx] = changed_site_idxs[change_idx];
+    new_probe_idxs[change_idx] = probe_idxs[changed_site_idxs[change_idx]];
+  }
+  return {
+    .changed_site_idxs = std::span<const size_t>(site_idxs, changed_site_idxs.size()),
+    .new_probe_idxs = std::span<const LayoutEvaluator::probe_idx_t>(new_probe_idxs, changed_site_idxs.size()),
+  };
+}
+
+Solver::ChangedSites Solver::create_solution_mutation(
+    const Solution::probe_quantities_t &free_site_probe_quantities,
+    LayoutEvaluator::probe_idxs_t &probe_idxs,
+    Solution::probe_quantities_t &unused_probe_quantities,
+    util::Xoshiro256PlusPlus &random_engine) const {
+  // only the changes are kept, so the array is left uninitialized past num_site_idxs
+  ChangedSites changed_sites;
+  changed_sites.num_site_idxs = 0;
+
+  // Slots are the free (mutable) sites followed by the unused probes. Unused probes are interchangeable, so the unused
+  // slots simply hold them ordered by probe idx.
+  const size_t num_unused_probes = std::accumulate(
+      unused_probe_quantities.cbegin(),
+      unused_probe_quantities.cend(),
+      size_t(0));
+  const size_t num_slots = mutable_site_idxs.size() + num_unused_probes;
+  const size_t inventory_size = FnSite::num_sites + num_unused_probes;
+  const auto probe_idx_in_slot = [&](size_t slot) {
+    if (slot < mutable_site_idxs.size()) {
+      return probe_idxs[mutable_site_idxs[slot]];
+    }
+
+    size_t unused_slot = slot - mutable_site_idxs.size();
+    size_t probe_idx = 0;
+    while (unused_slot >= unused_probe_quantities[probe_idx]) {
+      unused_slot -= unused_probe_quantities[probe_idx++];
+    }
+    return static_cast<LayoutEvaluator::probe_idx_t>(probe_idx);
+  };
+
+  // Only ordered slot pairs holding different probe types, and not both unused, change the layout. Swaps don't change
+  // how many slots hold each probe type, so this barely moves within one mutation.
+  double num_effective_pairs = static_cast<double>(num_slots) * static_cast<double>(num_slots)
+      - static_cast<double>(num_unused_probes) * static_cast<double>(num_unused_probes);
+  for (size_t probe_idx = 0; probe_idx < Probe::num_probes; ++probe_idx) {
+    const double num_probe_slots = free_site_probe_quantities[probe_idx] + unused_probe_quantities[probe_idx];
+    const double num_unused_probe_slots = unused_probe_quantities[probe_idx];
+    num_effective_pairs -= num_probe_slots * num_probe_slots - num_unused_probe_slots * num_unused_probe_slots;
   }
+
+  // Each slot mutates with the mutation rate, swapping with a partner drawn from the whole inventory, and only a
+  // mutable partner holding a different probe type changes anything. Thinning the mutations by the chance they're
+  // effective, and drawing only effective pairs, is the same process without the wasted draws.
+  const double slot_mutation_rate = num_slots == 0
+      ? 0.0
+      : options.get_mutation_rate() * num_effective_pairs
+          / (static_cast<double>(inventory_size) * static_cast<double>(num_slots));
+  if (slot_mutation_rate <= 0.0) {
+    return changed_sites;
+  }
+
+  // Skips straight to the next mutated slot, gaps are geometric. Kept as a double, so tiny rates can't overflow.
+  const double log_no_mutation_rate = std::log1p(-slot_mutation_rate);
+  std::uniform_real_distribution<double> get_unit(0.0, 1.0);
+  const auto get_gap = [&]() { return std::floor(std::log(1.0 - get_unit(random_engine)) / log_no_mutation_rate); };
+  std::uniform_int_distribution<size_t> get_slot(0, num_slots - 1);
+
+  std::array<bool, FnSite::num_sites> site_idx_is_changed;
+  site_idx_is_changed.fill(false);
+  const auto replace_probe_in_slot = [&](size_t slot, size_t old_probe_idx, size_t new_probe_idx) {
+    if (slot < mutable_site_idxs.size()) {
+      const size_t site_idx = mutable_site_idxs[slot];
+      probe_idxs[site_idx] = static_cast<LayoutEvaluator::probe_idx_t>(new_probe_idx);
+      if (!site_idx_is_changed[site_idx]) {
+        site_idx_is_changed[site_idx] = true;
+        changed_sites.site_idxs[changed_sites.num_site_idxs++] = site_idx;
+      }
+    } else {
+      --unused_probe_quantities[old_probe_idx];
+      ++unused_probe_quantities[new_probe_idx];
+    }
+  };
+
+  const auto drops_forced_collecting = [&](size_t slot, size_t new_probe_idx) {
+    return slot < mutable_site_idxs.size()
+        && site_idx_is_forced_collecting[mutable_site_idxs[slot]]
+        && !LayoutEvaluator::collects_precious_resources(new_probe_idx);
+  };
+
+  for (double mutation_slot = get_gap(); mutation_slot < static_cast<double>(num_slots);
+       mutation_slot += 1.0 + get_gap()) {
+    // uniform over the effective pairs, rejected pairs cost a couple of draws but never an evaluation
+    size_t slot_i;
+    size_t slot_j;
+    LayoutEvaluator::probe_idx_t probe_idx_i;
+    LayoutEvaluator::probe_idx_t probe_idx_j;
+    do {
+      slot_i = get_slot(random_engine);
+      slot_j = get_slot(random_engine);
+      probe_idx_i = probe_idx_in_slot(slot_i);
+      probe_idx_j = probe_idx_in_slot(slot_j);
+    } while (probe_idx_i == probe_idx_j
+      || (slot_i >= mutable_site_idxs.size() && slot_j >= mutable_site_idxs.size()));
+    // the slot keeps its probe rather than a forced site losing its collecting probe
+    if (drops_forced_collecting(slot_i, probe_idx_j) || drops_forced_collecting(slot_j, probe_idx_i)) {
+      continue;
+    }
+
+    replace_probe_in_slot(slot_i, probe_idx_i, probe_idx_j);
+    replace_probe_in_slot(slot_j, probe_idx_j, probe_idx_i);
+  }
+  return changed_sites;
 }
 
+bool Solver::repair_solution_mutation(
+    ChangedSites &changed_sites,
+    LayoutEvaluator::probe_idxs_t &probe_idxs,
+    Solution::probe_quantities_t &unused_probe_quantities,
+    std::array<uint32_t, precious_resource::count> &precious_resource_quantities) const {
+  // Each minimum counts by how far it's missed relative to itself, so that rare resources aren't drowned out.
+  const std::array<uint32_t, precious_resource::count> &minimums = options.get_precious_resource_minimums();
+  const auto shortfall_with = [&](
+      const std::array<uint32_t, precious_resource::count> &added_quantities,
+      const std::array<uint32_t, precious_resource::count> &removed_quantities) {
+    double shortfall = 0.0;
+    for (const size_t idx : constrained_precious_resource_idxs) {
+      const uint32_t quantity = precious_resource_quantities[idx] + added_quantities[idx] - removed_quantities[idx];
+      if (quantity < minimums[idx]) {
+        shortfall += static_cast<double>(minimums[idx] - quantity) / minimums[idx];
+      }
+    }
+    return shortfall;
+  };
+  const std::array<uint32_t, precious_resource::count> no_quantities{};
+
+  const auto mark_changed = [&](size_t site_idx) {
+    const std::span<const size_t> changed_site_idxs = changed_sites.get_site_idxs();
+    if (std::find(changed_site_idxs.begin(), changed_site_idxs.end(), site_idx) == changed_site_idxs.end()) {
+      changed_sites.site_idxs[changed_sites.num_site_idxs++] = site_idx;
+    }
+  };
+
+  double shortfall = shortfall_with(no_quantities, no_quantities);
+  while (shortfall > 0) {
+    // the site that would cover the most of what's missing, were it collecting
+    std::optional<size_t> maybe_target_site_idx;
+    double target_shortfall = shortfall;
+    for (const size_t site_idx : repair_site_idxs) {
+      if (LayoutEvaluator::collects_precious_resources(probe_idxs[site_idx])) {
+        continue;
+      }
+      const double site_shortfall = shortfall_with(FnSite::sites[site_idx].precious_resource_quantities, no_quantities);
+      if (site_shortfall < target_shortfall) {
+        maybe_target_site_idx = site_idx;
+        target_shortfall = site_shortfall;
+      }
+    }
+    if (!maybe_target_site_idx) {
+      break;
+    }
+    const size_t target_site_idx = *maybe_target_site_idx;
+    const std::array<uint32_t, precious_resource::count> &target_quantities
+        = FnSite::sites[target_site_idx].precious_resource_quantities;
+    const LayoutEvaluator::probe_idx_t target_probe_idx = probe_idxs[target_site_idx];
+
+    // Collecting probes are ordered from Basic up through the mining grades, so the first is the cheapest to give up.
+    // An unused one costs the layout nothing, otherwise take one from the site missing it the least.
+    std::optional<size_t> maybe_unused_probe_idx;
+    for (size_t probe_idx = 0; probe_idx < Probe::num_probes && !maybe_unused_probe_idx; ++probe_idx) {
+      if (unused_probe_quantities[probe_idx] > 0 && LayoutEvaluator::collects_precious_resources(probe_idx)) {
+        maybe_unused_probe_idx = probe_idx;
+      }
+    }
+    if (maybe_unused_probe_idx) {
+      --unused_probe_quantities[*maybe_unused_probe_idx];
+      ++unused_probe_quantities[target_probe_idx];
+      probe_idxs[target_site_idx] = static_cast<LayoutEvaluator::probe_idx_t>(*maybe_unused_probe_idx);
+      mark_changed(target_site_idx);
+    } else {
+      std::optional<size_t> maybe_source_site_idx;
+      double source_shortfall = shortfall;
+      for (const size_t site_idx : mutable_site_idxs) {
+        if (!LayoutEvaluator::collects_precious_resources(probe_idxs[site_idx])
+            || site_idx_is_forced_collecting[site_idx]) {
+          continue;
+        }
+        const double site_shortfall
+            = shortfall_with(target_quantities, FnSite::sites[site_idx].precious_resource_quantities);
+        if (site_shortfall < source_shortfall
+            || (maybe_source_site_idx && site_shortfall == source_shortfall
+              && probe_idxs[site_idx] < probe_idxs[*maybe_source_site_idx])) {
+          maybe_source_site_idx = site_idx;
+          source_shortfall = site_shortfall;
+        }
+      }
+      if (!maybe_source_site_idx) {
+        break;
+      }
+
+      const size_t source_site_idx = *maybe_source_site_idx;
+      for (size_t idx = 0; idx < precious_resource::count; ++idx) {
+        precious_resource_quantities[idx] -= FnSite::sites[source_site_idx].precious_resource_quantities[idx];
+      }
+      probe_idxs[target_site_idx] = probe_idxs[source_site_idx];
+      probe_idxs[source_site_idx] = target_probe_idx;
+      mark_changed(target_site_idx);
+      mark_changed(source_site_idx);
+    }
+
+    for (size_t idx = 0; idx < precious_resource::count; ++idx) {
+      precious_resource_quantities[idx] += target_quantities[idx];
+    }
+    shortfall = shortfall_with(no_quantities, no_quantities);
+  }
+  return shortfall == 0;
+}
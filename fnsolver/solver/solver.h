@@ -1,28 +1,78 @@
 #ifndef FNSOLVER_SOLVER_SOLVER_H
 #define FNSOLVER_SOLVER_SOLVER_H
 
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
 #include <fnsolver/data/probe.h>
 #include <fnsolver/layout/layout.h>
+#include <fnsolver/layout/layout_evaluator.h>
 #include <fnsolver/layout/placement.h>
+#include <fnsolver/solver/evaluation_cache.h>
 #include <fnsolver/solver/options.h>
+#include <fnsolver/solver/presolve.h>
 #include <fnsolver/solver/solution.h>
+#include <fnsolver/util/arena.hpp>
+#include <fnsolver/util/random.hpp>
+#include <fnsolver/util/seqlock.hpp>
 
+#include <array>
 #include <atomic>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
 #include <ostream>
 #include <random>
+#include <span>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 class Solver {
   public:
+    /** How one worker thread spent an iteration */
+    struct WorkerStatus {
+      /** Fraction of the iteration the worker spent on solutions, rather than waiting for the others to finish */
+      double utilization;
+      /** Chunks of the population the worker took from other workers' queues */
+      std::size_t num_steals;
+      /** Heap allocations the worker's arena made for offspring, none once it has grown to fit them */
+      std::size_t num_allocations;
+    };
+
+    /** The best solution as of some iteration. Never changes once published, so any thread may keep one around. */
+    struct BestSnapshot {
+      Solution solution;
+      Layout layout;
+      /** Iteration it was found in, 0 for the initial population */
+      uint32_t iteration;
+      /** Only ever false while no layout found so far meets them */
+      bool meets_constraints;
+    };
+
     struct IterationStatus {
       uint32_t iteration;
       double best_score;
       std::size_t num_killed;
+      /** Offspring skipped without evaluation for failing the precious resource minimums */
+      std::size_t num_rejected;
+      /** Offspring that failed the precious resource minimums as mutated, and how many of those repairs made meet them */
+      std::size_t num_repair_attempts;
+      std::size_t num_repaired;
+      /** Offspring skipped without evaluation because an upper bound on their score couldn't beat their parent */
+      std::size_t num_pruned;
+      /** Offspring whose mutation changed no site, skipped as they are their parent */
+      std::size_t num_unchanged;
+      /**
+       * Offspring looked up in the evaluation cache, and how many of those it saved evaluating, by holding their exact
+       * score or a bound on it that pruned them
+       */
+      std::size_t num_cache_lookups;
+      std::size_t num_cache_hits;
+      std::vector<WorkerStatus> worker_statuses;
       uint32_t last_improvement;
-      Layout best_layout;
+      /** Shared with the solver and every other status since the last improvement, rather than copied */
+      std::shared_ptr<const BestSnapshot> best_snapshot;
     };
     using ProgressCallback = std::function<void(IterationStatus)>;
     using StopCallback = std::function<bool()>;
@@ -36,20 +86,143 @@ class Solver {
 
     Solution run(const ProgressCallback& progress_callback, const StopCallback& stop_callback) const;
 
+    /** Latest best solution of the current or last run, null before any run. Any thread may call this at any time. */
+    std::shared_ptr<const BestSnapshot> get_best_snapshot() const;
+
   private:
+    /** Chunks each worker's share of the population is split into, the smaller they are the more evenly they spread */
+    static constexpr size_t chunks_per_worker = 8;
+
     Options options;
+    /** Swapped in on every improvement, so publishing never waits on whoever is reading the last one */
+    mutable std::atomic<std::shared_ptr<const BestSnapshot>> best_snapshot;
 
-    ScoreFunction constrained_score_function;
+    ScoreFunction::Constraints constraints;
+    Presolve presolve;
     std::vector<Placement> merged_locked_sites_and_seed;
     std::vector<bool> site_idx_is_seeded;
+    /** Sites whose probe may be swapped, a seeded site keeps its probe if the seed is forced or it's locked */
+    std::vector<size_t> mutable_site_idxs;
+    /** Precious resources with a minimum, the only ones repairs look at */
+    std::vector<size_t> constrained_precious_resource_idxs;
+    /** Mutable sites yielding any constrained precious resource, the only sites repairs swap collecting probes onto */
+    std::vector<size_t> repair_site_idxs;
+    /** Sites that must hold a collecting probe for the precious resource minimums to be met, see Presolve */
+    std::vector<bool> site_idx_is_forced_collecting;
     std::vector<const Probe *> inventory;
 
-    Solution create_random_solution(std::mt19937 &mt_engine) const;
-    std::pair<Solution, bool> create_solution_children_and_find_best(
+    /** What happened to the offspring of one or more solutions, see IterationStatus */
+    struct OffspringStats {
+      size_t num_rejected;
+      size_t num_repair_attempts;
+      size_t num_repaired;
+      size_t num_pruned;
+      size_t num_unchanged;
+      size_t num_cache_lookups;
+      size_t num_cache_hits;
+
+      OffspringStats &operator+=(const OffspringStats &other) {
+        num_rejected += other.num_rejected;
+        num_repair_attempts += other.num_repair_attempts;
+        num_repaired += other.num_repaired;
+        num_pruned += other.num_pruned;
+        num_unchanged += other.num_unchanged;
+        num_cache_lookups += other.num_cache_lookups;
+        num_cache_hits += other.num_cache_hits;
+        return *this;
+      }
+    };
+
+    /** The sites a child changes while it's drawn and repaired, in the order they change */
+    struct ChangedSites {
+      std::array<size_t, FnSite::num_sites> site_idxs;
+      size_t num_site_idxs;
+
+      std::span<const size_t> get_site_idxs() const {
+        return std::span<const size_t>(site_idxs.data(), num_site_idxs);
+      }
+    };
+
+    /**
+     * A child as the probes it puts on its parent's changed sites, not yet evaluated. The unused probes follow from
+     * those, since swaps never change how many of each probe there are. Only the changes themselves are kept, in the
+     * arena, as most children change a handful of sites.
+     */
+    struct Mutation {
+      std::span<const size_t> changed_site_idxs;
+      /** Parallel to changed_site_idxs */
+      std::span<const LayoutEvaluator::probe_idx_t> new_probe_idxs;
+
+      /** Copies changed_site_idxs and their new probes, from the child's probe_idxs, into arena */
+      static Mutation create(
+          std::span<const size_t> changed_site_idxs,
+          const LayoutEvaluator::probe_idxs_t &probe_idxs,
+          util::Arena &arena);
+
+      std::span<const size_t> get_changed_site_idxs() const {
+        return changed_site_idxs;
+      }
+
+      /** Turns the parent's probes and unused probes into the child's */
+      void apply(
+          LayoutEvaluator::probe_idxs_t &probe_idxs,
+          Solution::probe_quantities_t &unused_probe_quantities) const {
+        for (size_t change_idx = 0; change_idx < changed_site_idxs.size(); ++change_idx) {
+          const size_t site_idx = changed_site_idxs[change_idx];
+          ++unused_probe_quantities[probe_idxs[site_idx]];
+          --unused_probe_quantities[new_probe_idxs[change_idx]];
+          probe_idxs[site_idx] = new_probe_idxs[change_idx];
+        }
+      }
+
+      /** Undoes apply() */
+      void revert(
+          LayoutEvaluator::probe_idxs_t &probe_idxs,
+          Solution::probe_quantities_t &unused_probe_quantities,
+          const LayoutEvaluator::probe_idxs_t &parent_probe_idxs) const {
+        for (size_t change_idx = 0; change_idx < changed_site_idxs.size(); ++change_idx) {
+          const size_t site_idx = changed_site_idxs[change_idx];
+          ++unused_probe_quantities[new_probe_idxs[change_idx]];
+          --unused_probe_quantities[parent_probe_idxs[site_idx]];
+          probe_idxs[site_idx] = parent_probe_idxs[site_idx];
+        }
+      }
+    };
+
+    /** Scratch is allocated from arena, which the caller may reset once the solution is returned */
+    Solution create_random_solution(util::Xoshiro256PlusPlus &random_engine, util::Arena &arena) const;
+    /**
+     * The best child (or the solution itself), whether it was killed, and what happened to the other children.
+     * global_best is the best solution so far, which improving children are offered to if the best is shared.
+     */
+    std::tuple<Solution, bool, OffspringStats> create_solution_children_and_find_best(
         Solution solution,
-        const Solution &best_solution,
-        std::mt19937 &mt_engine) const;
-    Solution create_solution_mutation(const Solution &solution, std::mt19937 &mt_engine) const;
+        util::SeqLock<Solution> &global_best,
+        EvaluationCache &evaluation_cache,
+        util::Xoshiro256PlusPlus &random_engine,
+        util::Arena &arena) const;
+    /**
+     * free_site_probe_quantities counts the probes on the solution's mutable sites. The swaps are drawn on probe_idxs
+     * and unused_probe_quantities, which must hold the solution's, so they hold the child's on return until the
+     * Mutation created from the changed sites is reverted.
+     */
+    ChangedSites create_solution_mutation(
+        const Solution::probe_quantities_t &free_site_probe_quantities,
+        LayoutEvaluator::probe_idxs_t &probe_idxs,
+        Solution::probe_quantities_t &unused_probe_quantities,
+        util::Xoshiro256PlusPlus &random_engine) const;
+    /**
+     * Swaps probes collecting precious resources onto the mutable sites yielding the ones a child misses, cheapest
+     * first, until it meets the minimums or no swap gets it any closer, never taking one off a forced site.
+     * probe_idxs, unused_probe_quantities, and precious_resource_quantities must hold the child's, as they do after
+     * create_solution_mutation(), and are kept up to date along with changed_sites. Returns whether the child meets the
+     * minimums now.
+     */
+    bool repair_solution_mutation(
+        ChangedSites &changed_sites,
+        LayoutEvaluator::probe_idxs_t &probe_idxs,
+        Solution::probe_quantities_t &unused_probe_quantities,
+        std::array<uint32_t, precious_resource::count> &precious_resource_quantities) const;
 };
 
 #endif // FNSOLVER_SOLVER_SOLVER_H
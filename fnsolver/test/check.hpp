@@ -0,0 +1,37 @@
+#ifndef FNSOLVER_TEST_CHECK_HPP
+#define FNSOLVER_TEST_CHECK_HPP
+
+#include <iostream>
+
+namespace test {
+
+/** Checks failed so far, a test's main() returns result() */
+inline int num_failures = 0;
+
+inline void check(bool passed, const char *expression, const char *file, int line) {
+  if (!passed) {
+    std::cerr << file << ":" << line << ": check failed: " << expression << std::endl;
+    ++num_failures;
+  }
+}
+
+/** Whether calling function throws an Exception */
+template <typename Exception, typename Function>
+bool throws(Function function) {
+  try {
+    function();
+  } catch (const Exception &) {
+    return true;
+  }
+  return false;
+}
+
+inline int result() {
+  return num_failures == 0 ? 0 : 1;
+}
+
+} // namespace test
+
+#define CHECK(expression) test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#endif // FNSOLVER_TEST_CHECK_HPP
@@ -0,0 +1,147 @@
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/layout/layout_evaluator.h>
+#include <fnsolver/layout/placement.h>
+#include <fnsolver/layout/reference_resolution.h>
+#include <fnsolver/layout/resolved_placement.h>
+#include <fnsolver/test/check.hpp>
+#include <fnsolver/util/random.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace {
+/** Drawn from only a few probes, so that chains and booster/duplicator neighborhoods are common */
+LayoutEvaluator::probe_idxs_t random_probe_idxs(util::Xoshiro256PlusPlus &random_engine) {
+  std::uniform_int_distribution<size_t> get_probe_idx(0, Probe::num_probes - 1);
+  std::array<size_t, 4> palette;
+  for (size_t &probe_idx : palette) {
+    probe_idx = get_probe_idx(random_engine);
+  }
+
+  std::uniform_int_distribution<size_t> get_palette_idx(0, palette.size() - 1);
+  LayoutEvaluator::probe_idxs_t probe_idxs;
+  for (LayoutEvaluator::probe_idx_t &probe_idx : probe_idxs) {
+    probe_idx = static_cast<LayoutEvaluator::probe_idx_t>(palette[get_palette_idx(random_engine)]);
+  }
+  return probe_idxs;
+}
+
+std::vector<Placement> placements_for(const LayoutEvaluator::probe_idxs_t &probe_idxs) {
+  std::vector<Placement> placements;
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    placements.emplace_back(FnSite::sites[site_idx], Probe::probes[probe_idxs[site_idx]]);
+  }
+  return placements;
+}
+
+void check_matches_reference(const LayoutEvaluator &evaluator) {
+  const std::vector<ResolvedPlacement> resolved_placements
+      = reference_resolution::resolve_placements(placements_for(evaluator.get_probe_idxs()));
+  for (size_t site_idx = 0; site_idx < FnSite::num_sites; ++site_idx) {
+    const ResolvedPlacement &resolved_placement = resolved_placements[site_idx];
+    const std::span<const uint32_t> outgoing_boost_factors = evaluator.get_outgoing_boost_factors(site_idx);
+    CHECK(evaluator.get_chain_bonus(site_idx) == resolved_placement.get_chain_bonus());
+    CHECK(std::equal(
+        outgoing_boost_factors.begin(),
+        outgoing_boost_factors.end(),
+        resolved_placement.get_outgoing_boost_factors().cbegin(),
+        resolved_placement.get_outgoing_boost_factors().cend()));
+    CHECK(evaluator.get_site_production(site_idx) == resolved_placement.get_resource_yield().get_production());
+    CHECK(evaluator.get_site_revenue(site_idx) == resolved_placement.get_resource_yield().get_revenue());
+    CHECK(evaluator.get_site_storage(site_idx) == resolved_placement.get_resource_yield().get_storage());
+  }
+
+  const ResourceYield reference_yield = reference_resolution::resolve_resource_yield(resolved_placements);
+  CHECK(evaluator.get_production() == reference_yield.get_production());
+  CHECK(evaluator.get_revenue() == reference_yield.get_revenue());
+  CHECK(evaluator.get_storage() == reference_yield.get_storage());
+  CHECK(evaluator.get_precious_resource_quantities() == reference_yield.get_precious_resource_quantities());
+}
+
+void test_evaluate_matches_reference() {
+  util::Xoshiro256PlusPlus random_engine(1, 0);
+  LayoutEvaluator evaluator;
+  for (size_t layout_idx = 0; layout_idx < 1000; ++layout_idx) {
+    evaluator.evaluate(random_probe_idxs(random_engine));
+    check_matches_reference(evaluator);
+  }
+}
+
+/** Changes 1 to 4 sites of probe_idxs to another layout's probes, which keeps the chains long. Returns the changed sites. */
+std::vector<size_t> random_changes(util::Xoshiro256PlusPlus &random_engine, LayoutEvaluator::probe_idxs_t &probe_idxs) {
+  std::uniform_int_distribution<size_t> get_site_idx(0, FnSite::num_sites - 1);
+  std::uniform_int_distribution<size_t> get_num_changes(1, 4);
+  const LayoutEvaluator::probe_idxs_t donor_probe_idxs = random_probe_idxs(random_engine);
+  std::vector<size_t> changed_site_idxs;
+  for (size_t change_idx = get_num_changes(random_engine); change_idx > 0; --change_idx) {
+    const size_t site_idx = get_site_idx(random_engine);
+    if (std::find(changed_site_idxs.cbegin(), changed_site_idxs.cend(), site_idx) == changed_site_idxs.cend()) {
+      changed_site_idxs.push_back(site_idx);
+      probe_idxs[site_idx] = donor_probe_idxs[site_idx];
+    }
+  }
+  return changed_site_idxs;
+}
+
+void test_reevaluate_matches_reference() {
+  util::Xoshiro256PlusPlus random_engine(2, 0);
+  LayoutEvaluator evaluator;
+  for (size_t layout_idx = 0; layout_idx < 200; ++layout_idx) {
+    evaluator.evaluate(random_probe_idxs(random_engine));
+    for (size_t round = 0; round < 10; ++round) {
+      LayoutEvaluator::probe_idxs_t probe_idxs = evaluator.get_probe_idxs();
+      const std::vector<size_t> changed_site_idxs = random_changes(random_engine, probe_idxs);
+      evaluator.reevaluate(probe_idxs, changed_site_idxs);
+      check_matches_reference(evaluator);
+    }
+  }
+}
+
+void test_resource_yield_bound_holds() {
+  util::Xoshiro256PlusPlus random_engine(4, 0);
+  LayoutEvaluator evaluator;
+  for (size_t layout_idx = 0; layout_idx < 200; ++layout_idx) {
+    evaluator.evaluate(random_probe_idxs(random_engine));
+    for (size_t round = 0; round < 10; ++round) {
+      LayoutEvaluator::probe_idxs_t probe_idxs = evaluator.get_probe_idxs();
+      const std::vector<size_t> changed_site_idxs = random_changes(random_engine, probe_idxs);
+      const ResourceYield bound = evaluator.get_resource_yield_bound_for(probe_idxs, changed_site_idxs);
+      evaluator.reevaluate(probe_idxs, changed_site_idxs);
+      CHECK(bound.get_production() >= evaluator.get_production());
+      CHECK(bound.get_revenue() >= evaluator.get_revenue());
+      CHECK(bound.get_storage() >= evaluator.get_storage());
+      CHECK(bound.get_precious_resource_quantities() == evaluator.get_precious_resource_quantities());
+    }
+  }
+}
+
+void test_territory_overrides_match_reference() {
+  util::Xoshiro256PlusPlus random_engine(3, 0);
+  for (const FnSite &site : FnSite::sites) {
+    FnSite::override_territories(
+        site.site_id,
+        std::uniform_int_distribution<uint32_t>(0, site.max_territories)(random_engine));
+  }
+
+  LayoutEvaluator evaluator;
+  for (size_t layout_idx = 0; layout_idx < 200; ++layout_idx) {
+    evaluator.evaluate(random_probe_idxs(random_engine));
+    check_matches_reference(evaluator);
+  }
+  FnSite::reset_territories();
+}
+} // namespace
+
+int main() {
+  test_evaluate_matches_reference();
+  test_reevaluate_matches_reference();
+  test_resource_yield_bound_holds();
+  test_territory_overrides_match_reference();
+  return test::result();
+}
@@ -0,0 +1,129 @@
+#include <fnsolver/data/fnsite.h>
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/probe.h>
+#include <fnsolver/solver/options.h>
+#include <fnsolver/solver/presolve.h>
+#include <fnsolver/solver/score_function.h>
+#include <fnsolver/test/check.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+/** The "all_de" inventory with the Mining probes replaced by mining_quantities, and Basic probes on any sites left */
+std::array<uint32_t, Probe::num_probes> probe_quantities_with(
+    const std::map<std::string, uint32_t> &mining_quantities) {
+  std::map<std::string, uint32_t> probe_quantity_for_shorthand = {
+    {"R1", 3}, {"R2", 4}, {"R3", 2}, {"R4", 6}, {"R5", 7}, {"R6", 12},
+    {"B1", 6}, {"B2", 6},
+    {"D", 10},
+    {"S", 22}
+  };
+  probe_quantity_for_shorthand.insert(mining_quantities.cbegin(), mining_quantities.cend());
+
+  std::array<uint32_t, Probe::num_probes> probe_quantities;
+  probe_quantities.fill(0);
+  for (const auto &[shorthand, quantity] : probe_quantity_for_shorthand) {
+    probe_quantities[Probe::idx_for_shorthand.at(shorthand)] = quantity;
+  }
+
+  const uint32_t num_probes = std::accumulate(probe_quantities.cbegin(), probe_quantities.cend(), uint32_t(0));
+  if (num_probes < FnSite::num_sites) {
+    probe_quantities[Probe::idx_for_shorthand.at("-")] = static_cast<uint32_t>(FnSite::num_sites) - num_probes;
+  }
+  return probe_quantities;
+}
+
+/** Minimums of everything there is of each of precious_resource_types */
+std::array<uint32_t, precious_resource::count> minimums_of_all(
+    const std::vector<precious_resource::Type> &precious_resource_types) {
+  std::array<uint32_t, precious_resource::count> minimums;
+  minimums.fill(0);
+  for (const precious_resource::Type precious_resource_type : precious_resource_types) {
+    const size_t idx = static_cast<size_t>(precious_resource_type);
+    for (const FnSite &site : FnSite::sites) {
+      minimums[idx] += site.precious_resource_quantities[idx];
+    }
+  }
+  return minimums;
+}
+
+Options options_with(
+    std::array<uint32_t, Probe::num_probes> probe_quantities,
+    std::array<uint32_t, precious_resource::count> precious_resource_minimums) {
+  return Options(
+      true,
+      ScoreFunction::create_max_mining(),
+      std::nullopt,
+      probe_quantities,
+      {},
+      {},
+      {},
+      false,
+      precious_resource_minimums,
+      0,
+      0,
+      0,
+      ScoreFunction::ConstraintMode::zero,
+      false,
+      1,
+      0,
+      1,
+      1,
+      0.04,
+      1,
+      1,
+      std::nullopt,
+      false);
+}
+
+// Sites holding any of these add up to 32, more than a few Mining probes and the Basic probes filling the rest cover
+const std::vector<precious_resource::Type> six_precious_resource_types = {
+  precious_resource::Type::arc_sand_ore,
+  precious_resource::Type::aurorite,
+  precious_resource::Type::white_cometite,
+  precious_resource::Type::enduron_lead,
+  precious_resource::Type::everfreeze_ore,
+  precious_resource::Type::lionbone_bort
+};
+
+void test_forced_sites_within_collecting_probes() {
+  const Presolve presolve(options_with(
+      probe_quantities_with({
+        {"M1", 20}, {"M2", 24}, {"M3", 7}, {"M4", 15}, {"M5", 9}, {"M6", 10}, {"M7", 4}, {"M8", 23}, {"M9", 10},
+        {"M10", 11}
+      }),
+      minimums_of_all(six_precious_resource_types)));
+  CHECK(!presolve.is_infeasible());
+  CHECK(presolve.get_forced_collecting_site_idxs().size() == 32);
+  CHECK(presolve.get_num_required_collecting_sites() == 32);
+  CHECK(presolve.get_num_collecting_probes() >= 32);
+}
+
+void test_forced_sites_beyond_collecting_probes() {
+  // each minimum can be met on its own, but not all of them with 26 collecting probes
+  const Presolve presolve(
+      options_with(probe_quantities_with({{"M1", 3}}), minimums_of_all(six_precious_resource_types)));
+  CHECK(std::all_of(
+      presolve.get_bounds().cbegin(),
+      presolve.get_bounds().cend(),
+      std::mem_fn(&Presolve::Bound::can_be_met)));
+  CHECK(presolve.get_num_collecting_probes() == 26);
+  CHECK(presolve.get_num_required_collecting_sites() == 32);
+  CHECK(presolve.is_infeasible());
+  CHECK(presolve.get_forced_collecting_site_idxs().empty());
+}
+} // namespace
+
+int main() {
+  test_forced_sites_within_collecting_probes();
+  test_forced_sites_beyond_collecting_probes();
+  return test::result();
+}
@@ -0,0 +1,74 @@
+#include <fnsolver/data/precious_resource.h>
+#include <fnsolver/data/resource_yield.h>
+#include <fnsolver/data/resource_yield_batch.h>
+#include <fnsolver/solver/score_expression.h>
+#include <fnsolver/test/check.hpp>
+
+#include <array>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+ResourceYield resource_yield_of(uint32_t production, uint32_t revenue, uint32_t storage) {
+  return ResourceYield(production, revenue, storage, std::array<uint32_t, precious_resource::count>{});
+}
+
+/** "mining * 1 + mining * 2 + ...", which keeps num_constants constants and two intermediate results */
+std::string sum_of_scaled_mining(size_t num_constants) {
+  std::string text = "mining * 1";
+  for (size_t constant = 2; constant <= num_constants; ++constant) {
+    text += std::format(" + mining * {}", constant);
+  }
+  return text;
+}
+
+void test_register_limit() {
+  // the 18 variables, 44 constants, and 2 intermediate results just fit in the registers
+  CHECK(ScoreExpression(sum_of_scaled_mining(44))(resource_yield_of(1, 0, 0)) == 44 * 45 / 2);
+  CHECK(test::throws<std::invalid_argument>([]() { ScoreExpression(sum_of_scaled_mining(45)); }));
+  CHECK(test::throws<std::invalid_argument>([]() { ScoreExpression(sum_of_scaled_mining(100)); }));
+}
+
+/** The score of each yield, scored alone and as one batch, which must agree */
+std::vector<double> scores_of(const ScoreExpression &expression, const std::vector<ResourceYield> &resource_yields) {
+  ResourceYieldBatch batch;
+  std::vector<double> scores;
+  for (const ResourceYield &resource_yield : resource_yields) {
+    batch.push_back(resource_yield);
+    scores.push_back(expression(resource_yield));
+  }
+
+  std::vector<double> batch_scores(resource_yields.size());
+  expression(batch, batch_scores);
+  CHECK(batch_scores == scores);
+  return scores;
+}
+
+void test_division_by_zero() {
+  const std::vector<ResourceYield> resource_yields = {resource_yield_of(100, 0, 0), resource_yield_of(100, 0, 50)};
+  CHECK(scores_of(ScoreExpression("mining / storage"), resource_yields) == std::vector<double>({0.0, 2.0}));
+  CHECK(scores_of(ScoreExpression("0 * (mining / storage)"), resource_yields) == std::vector<double>({0.0, 0.0}));
+  CHECK(scores_of(ScoreExpression("mining / (storage - storage) + 1"), resource_yields)
+      == std::vector<double>({1.0, 1.0}));
+  // folded while parsing, the same way
+  CHECK(scores_of(ScoreExpression("mining + 1 / 0"), resource_yields) == std::vector<double>({100.0, 100.0}));
+}
+
+void test_not_a_number() {
+  // infinity minus infinity, and 0 times infinity
+  CHECK(scores_of(ScoreExpression("mining * 1e300 * 1e300 - storage * 1e300 * 1e300 + 1"), {resource_yield_of(1, 0, 1)})
+      == std::vector<double>({1.0}));
+  CHECK(scores_of(ScoreExpression("storage * (mining * 1e300 * 1e300) + 1"), {resource_yield_of(1, 0, 0)})
+      == std::vector<double>({1.0}));
+}
+} // namespace
+
+int main() {
+  test_register_limit();
+  test_division_by_zero();
+  test_not_a_number();
+  return test::result();
+}
@@ -0,0 +1,92 @@
+#ifndef FNSOLVER_UTIL_ARENA_HPP
+#define FNSOLVER_UTIL_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace util {
+
+/**
+ * Bump allocator for short-lived allocations that all die together. Unlike std::pmr::monotonic_buffer_resource,
+ * reset() keeps the memory for the next round, so once the arena has grown to fit the most that was ever allocated
+ * between two resets, it never touches the heap again.
+ */
+class Arena : public std::pmr::memory_resource {
+  public:
+    Arena() = default;
+
+    Arena(const Arena &other) = delete;
+    Arena(Arena &&other) = delete;
+    Arena &operator=(const Arena &other) = delete;
+    Arena &operator=(Arena &&other) = delete;
+
+    /** Frees everything allocated since the last reset, none of which may still be in use. */
+    void reset() {
+      if (blocks.size() > 1) {
+        // coalesce, so that everything allocated since the last reset fits in a single block from now on
+        size_t total_size = 0;
+        for (const Block &block : blocks) {
+          total_size += block.size;
+        }
+        blocks.clear();
+        add_block(total_size);
+      }
+      offset = 0;
+    }
+
+    /** Blocks taken from the heap so far */
+    size_t get_num_allocations() const { return num_allocations; }
+  private:
+    static constexpr size_t min_block_size = 64 * 1024;
+
+    struct Block {
+      std::unique_ptr<std::byte[]> data;
+      size_t size;
+    };
+
+    std::vector<Block> blocks;
+    /** Into the last block, the others are full */
+    size_t offset = 0;
+    size_t num_allocations = 0;
+
+    void add_block(size_t size) {
+      blocks.push_back({.data = std::unique_ptr<std::byte[]>(new std::byte[size]), .size = size});
+      offset = 0;
+      ++num_allocations;
+    }
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+      if (void *ptr = allocate_from_last_block(bytes, alignment)) {
+        return ptr;
+      }
+
+      add_block(std::max({min_block_size, bytes + alignment, blocks.empty() ? 0 : 2 * blocks.back().size}));
+      return allocate_from_last_block(bytes, alignment);
+    }
+
+    void do_deallocate(void * /*ptr*/, size_t /*bytes*/, size_t /*alignment*/) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    void *allocate_from_last_block(size_t bytes, size_t alignment) {
+      if (blocks.empty()) {
+        return nullptr;
+      }
+
+      void *ptr = blocks.back().data.get() + offset;
+      size_t space = blocks.back().size - offset;
+      if (!std::align(alignment, bytes, ptr, space)) {
+        return nullptr;
+      }
+      offset = static_cast<std::byte *>(ptr) - blocks.back().data.get() + bytes;
+      return ptr;
+    }
+};
+
+} // namespace util
+
+#endif // FNSOLVER_UTIL_ARENA_HPP
@@ -0,0 +1,61 @@
+#ifndef FNSOLVER_UTIL_RANDOM_HPP
+#define FNSOLVER_UTIL_RANDOM_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace util {
+
+/** Advances state and returns its next SplitMix64 output, good for turning structured keys into seeds. */
+constexpr uint64_t splitmix64(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+  return z ^ (z >> 31);
+}
+
+/**
+ * xoshiro256++, a small and fast UniformRandomBitGenerator. Keyed by (seed, stream) through SplitMix64, so any stream
+ * can be recreated from its key alone, regardless of which thread draws from it or what was drawn before.
+ */
+class Xoshiro256PlusPlus {
+  public:
+    using result_type = uint64_t;
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    constexpr Xoshiro256PlusPlus(uint64_t seed, uint64_t stream) : state() {
+      uint64_t splitmix_state = seed;
+      splitmix_state ^= splitmix64(stream);
+      for (uint64_t &word : state) {
+        word = splitmix64(splitmix_state);
+      }
+    }
+
+    constexpr Xoshiro256PlusPlus(const Xoshiro256PlusPlus &other) = default;
+    constexpr Xoshiro256PlusPlus(Xoshiro256PlusPlus &&other) = default;
+    constexpr Xoshiro256PlusPlus &operator=(const Xoshiro256PlusPlus &other) = default;
+    constexpr Xoshiro256PlusPlus &operator=(Xoshiro256PlusPlus &&other) = default;
+
+    constexpr result_type operator()() {
+      const uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+      const uint64_t t = state[1] << 17;
+      state[2] ^= state[0];
+      state[3] ^= state[1];
+      state[1] ^= state[2];
+      state[0] ^= state[3];
+      state[2] ^= t;
+      state[3] = rotl(state[3], 45);
+      return result;
+    }
+  private:
+    std::array<uint64_t, 4> state;
+
+    static constexpr uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+} // namespace util
+
+#endif // FNSOLVER_UTIL_RANDOM_HPP
@@ -0,0 +1,100 @@
+#ifndef FNSOLVER_UTIL_SEQLOCK_HPP
+#define FNSOLVER_UTIL_SEQLOCK_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace util {
+
+/**
+ * Small trivially copyable value that many threads read and update at once. Readers never lock. They copy the value
+ * word by word and retry if a writer was busy in the meantime. Writers take turns by bumping the sequence number to
+ * odd while they write, which only ever makes readers retry, never wait on a lock.
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>);
+  public:
+    explicit SeqLock(const T &value) { write(value); }
+
+    SeqLock(const SeqLock &other) = delete;
+    SeqLock(SeqLock &&other) = delete;
+    SeqLock &operator=(const SeqLock &other) = delete;
+    SeqLock &operator=(SeqLock &&other) = delete;
+
+    T load() const {
+      while (true) {
+        const uint64_t start_sequence = sequence.load(std::memory_order_acquire);
+        if (start_sequence % 2 == 1) {
+          continue; // mid-write
+        }
+
+        const T value = read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == start_sequence) {
+          return value;
+        }
+      }
+    }
+
+    /** Replaces the value with value if should_replace(current value) holds, returns whether it did */
+    template <typename Predicate>
+    bool store_if(const T &value, Predicate should_replace) {
+      while (true) {
+        uint64_t start_sequence = sequence.load(std::memory_order_acquire);
+        if (start_sequence % 2 == 1) {
+          continue; // another writer
+        }
+
+        const T current_value = read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != start_sequence) {
+          continue; // torn read
+        }
+        if (!should_replace(current_value)) {
+          return false;
+        }
+
+        if (sequence.compare_exchange_weak(start_sequence, start_sequence + 1, std::memory_order_acquire)) {
+          std::atomic_thread_fence(std::memory_order_release);
+          write(value);
+          sequence.store(start_sequence + 2, std::memory_order_release);
+          return true;
+        }
+      }
+    }
+  private:
+    static constexpr size_t num_words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    /** Even while no writer is writing */
+    std::atomic<uint64_t> sequence = 0;
+    /** Relaxed atomics, so copying while a writer writes is merely torn (and retried), not a data race */
+    std::array<std::atomic<uint64_t>, num_words> words;
+
+    T read() const {
+      std::array<uint64_t, num_words> raw_words;
+      for (size_t word_idx = 0; word_idx < num_words; ++word_idx) {
+        raw_words[word_idx] = words[word_idx].load(std::memory_order_relaxed);
+      }
+      std::array<std::byte, sizeof(T)> bytes;
+      std::memcpy(bytes.data(), raw_words.data(), sizeof(T));
+      return std::bit_cast<T>(bytes);
+    }
+
+    void write(const T &value) {
+      std::array<uint64_t, num_words> raw_words{};
+      std::memcpy(raw_words.data(), &value, sizeof(T));
+      for (size_t word_idx = 0; word_idx < num_words; ++word_idx) {
+        words[word_idx].store(raw_words[word_idx], std::memory_order_relaxed);
+      }
+    }
+};
+
+} // namespace util
+
+#endif // FNSOLVER_UTIL_SEQLOCK_HPP
@@ -0,0 +1,16 @@
+#ifndef FNSOLVER_UTIL_SIMD_HPP
+#define FNSOLVER_UTIL_SIMD_HPP
+
+/**
+ * Compiles a function once per listed instruction set, and picks the best one for the running CPU when the program is
+ * loaded. Write the function as a plain loop over its lanes and let the compiler vectorize each clone.
+ *
+ * Needs ifunc support, so anywhere other than x86-64 Linux this only produces the default (scalar) build.
+ */
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+#define FNSOLVER_SIMD_CLONES __attribute__((target_clones("avx2", "sse4.2", "default")))
+#else
+#define FNSOLVER_SIMD_CLONES
+#endif
+
+#endif // FNSOLVER_UTIL_SIMD_HPP
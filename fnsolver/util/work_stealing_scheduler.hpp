@@ -0,0 +1,100 @@
+#ifndef FNSOLVER_UTIL_WORK_STEALING_SCHEDULER_HPP
+#define FNSOLVER_UTIL_WORK_STEALING_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace util {
+
+/**
+ * Hands out the items [0, num_items) in chunks. Chunks are dealt evenly to one queue per worker, and a worker takes
+ * from the front of its own queue. Once its queue runs dry, it steals from the back of the others'. Each queue is a
+ * single atomic (front, back) pair of chunk indices, so neither taking nor stealing ever locks.
+ */
+class WorkStealingScheduler {
+  public:
+    struct Chunk {
+      size_t start_idx;
+      size_t end_idx;
+      /** Whether the chunk was dealt to another worker */
+      bool stolen;
+    };
+
+    explicit WorkStealingScheduler(size_t num_workers) : queues(num_workers), num_items(0), chunk_size(1) {}
+
+    WorkStealingScheduler(const WorkStealingScheduler &other) = delete;
+    WorkStealingScheduler(WorkStealingScheduler &&other) = delete;
+    WorkStealingScheduler &operator=(const WorkStealingScheduler &other) = delete;
+    WorkStealingScheduler &operator=(WorkStealingScheduler &&other) = delete;
+
+    /** Deals out [0, num_items) again, must not race with next(). */
+    void reset(size_t num_items, size_t chunk_size) {
+      this->num_items = num_items;
+      this->chunk_size = std::max<size_t>(chunk_size, 1);
+      const size_t num_chunks = (num_items + this->chunk_size - 1) / this->chunk_size;
+      for (size_t worker_idx = 0; worker_idx < queues.size(); ++worker_idx) {
+        queues[worker_idx].range.store(
+            pack((worker_idx * num_chunks) / queues.size(), ((worker_idx + 1) * num_chunks) / queues.size()),
+            std::memory_order_relaxed);
+      }
+    }
+
+    /** The next chunk worker_idx should work on, or none once every queue is empty */
+    std::optional<Chunk> next(size_t worker_idx) {
+      if (const std::optional<uint64_t> maybe_chunk_idx = take_front(queues[worker_idx])) {
+        return chunk(*maybe_chunk_idx, false);
+      }
+      for (size_t offset = 1; offset < queues.size(); ++offset) {
+        if (const std::optional<uint64_t> maybe_chunk_idx = take_back(queues[(worker_idx + offset) % queues.size()])) {
+          return chunk(*maybe_chunk_idx, true);
+        }
+      }
+      return {};
+    }
+  private:
+    struct Queue {
+      // own cache line, every worker hammers its own queue
+      alignas(64) std::atomic<uint64_t> range{0};
+    };
+
+    std::vector<Queue> queues;
+    size_t num_items;
+    size_t chunk_size;
+
+    static uint64_t pack(uint64_t front, uint64_t back) { return (front << 32) | back; }
+
+    static std::optional<uint64_t> take_front(Queue &queue) {
+      uint64_t range = queue.range.load(std::memory_order_relaxed);
+      while ((range >> 32) < (range & 0xFFFFFFFF)) {
+        if (queue.range.compare_exchange_weak(range, range + (uint64_t(1) << 32), std::memory_order_relaxed)) {
+          return range >> 32;
+        }
+      }
+      return {};
+    }
+
+    static std::optional<uint64_t> take_back(Queue &queue) {
+      uint64_t range = queue.range.load(std::memory_order_relaxed);
+      while ((range >> 32) < (range & 0xFFFFFFFF)) {
+        if (queue.range.compare_exchange_weak(range, range - 1, std::memory_order_relaxed)) {
+          return (range & 0xFFFFFFFF) - 1;
+        }
+      }
+      return {};
+    }
+
+    Chunk chunk(uint64_t chunk_idx, bool stolen) const {
+      return Chunk{
+        .start_idx = chunk_idx * chunk_size,
+        .end_idx = std::min(num_items, (chunk_idx + 1) * chunk_size),
+        .stolen = stolen,
+      };
+    }
+};
+
+} // namespace util
+
+#endif // FNSOLVER_UTIL_WORK_STEALING_SCHEDULER_HPP
@@ -0,0 +1,129 @@
+#ifndef FNSOLVER_UTIL_WORKER_POOL_HPP
+#define FNSOLVER_UTIL_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * Fixed set of workers that run one task after another. Each task is handed off by bumping an epoch, rather than
+ * spawning and joining threads for every task. The calling thread works as worker 0, so a pool of one worker never
+ * starts a thread at all.
+ */
+class WorkerPool {
+  public:
+    explicit WorkerPool(size_t num_workers) : num_workers(num_workers) {
+      for (size_t worker_idx = 1; worker_idx < num_workers; ++worker_idx) {
+        threads.emplace_back([this, worker_idx]() { work(worker_idx); });
+      }
+    }
+
+    ~WorkerPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      task_ready.notify_all();
+      for (std::thread &thread : threads) {
+        thread.join();
+      }
+    }
+
+    WorkerPool(const WorkerPool &other) = delete;
+    WorkerPool(WorkerPool &&other) = delete;
+    WorkerPool &operator=(const WorkerPool &other) = delete;
+    WorkerPool &operator=(WorkerPool &&other) = delete;
+
+    size_t size() const { return num_workers; }
+
+    /**
+     * Runs task(worker_idx) once on every worker, and returns once all of them have finished. Rethrows the first
+     * exception any of them threw.
+     */
+    void run(const std::function<void(size_t)> &task) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_task = &task;
+        ++epoch;
+        num_running = threads.size();
+        maybe_exception = nullptr;
+      }
+      task_ready.notify_all();
+
+      std::exception_ptr maybe_own_exception;
+      try {
+        task(0);
+      } catch (...) {
+        maybe_own_exception = std::current_exception();
+      }
+
+      std::unique_lock<std::mutex> lock(mutex);
+      task_done.wait(lock, [this]() { return num_running == 0; });
+      current_task = nullptr;
+      if (maybe_own_exception) {
+        std::rethrow_exception(maybe_own_exception);
+      }
+      if (maybe_exception) {
+        std::rethrow_exception(maybe_exception);
+      }
+    }
+  private:
+    size_t num_workers;
+
+    std::mutex mutex;
+    std::condition_variable task_ready;
+    std::condition_variable task_done;
+    const std::function<void(size_t)> *current_task = nullptr;
+    uint64_t epoch = 0;
+    size_t num_running = 0;
+    bool stopping = false;
+    std::exception_ptr maybe_exception;
+
+    // last, so that everything the workers touch exists before they start
+    std::vector<std::thread> threads;
+
+    void work(size_t worker_idx) {
+      uint64_t last_epoch = 0;
+      while (true) {
+        const std::function<void(size_t)> *task;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          task_ready.wait(lock, [&, this]() { return stopping || epoch != last_epoch; });
+          if (stopping) {
+            return;
+          }
+          last_epoch = epoch;
+          task = current_task;
+        }
+
+        std::exception_ptr maybe_task_exception;
+        try {
+          (*task)(worker_idx);
+        } catch (...) {
+          maybe_task_exception = std::current_exception();
+        }
+
+        bool all_done;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (maybe_task_exception && !maybe_exception) {
+            maybe_exception = maybe_task_exception;
+          }
+          all_done = --num_running == 0;
+        }
+        if (all_done) {
+          task_done.notify_one();
+        }
+      }
+    }
+};
+
+} // namespace util
+
+#endif // FNSOLVER_UTIL_WORKER_POOL_HPP